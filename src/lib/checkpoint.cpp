@@ -0,0 +1,290 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "checkpoint.h"
+#include "middleware/hex.h"
+
+#include <omw/defs.h>
+
+#ifdef OMW_PLAT_WIN
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const magic = "treesha1sum-checkpoint";
+const int formatVersion = 1;
+
+std::FILE* openFile(const fs::path& path, const char* mode)
+{
+#ifdef OMW_PLAT_WIN
+    return ::_wfopen(path.c_str(), fs::path(mode).c_str());
+#else
+    return std::fopen(path.c_str(), mode);
+#endif
+}
+
+void writeFile(std::FILE* file, const fs::path& path, const std::string& data)
+{
+    if (std::fwrite(data.data(), 1, data.size(), file) != data.size())
+    {
+        throw fs::filesystem_error("failed to write file", path, std::error_code(errno, std::generic_category()));
+    }
+}
+
+void syncFile(std::FILE* file)
+{
+    std::fflush(file);
+#ifdef OMW_PLAT_WIN
+    ::_commit(::_fileno(file));
+#else
+    ::fsync(::fileno(file));
+#endif
+}
+
+} // namespace
+
+
+
+treesha1sum::Checkpoint::Checkpoint(const fs::path& file, const fs::path& root, const std::string& digestType, bool resume, std::chrono::seconds interval)
+    : m_file(file), m_interval(interval), m_loaded(), m_mtx(), m_journal(nullptr), m_lastFlush(std::chrono::steady_clock::now())
+{
+    const std::string rootKey = pathKey(root);
+
+    if (resume && fs::exists(m_file)) { m_load(rootKey, digestType); }
+
+    // write the compacted journal to a temporary file and atomically replace the old one
+    std::ostringstream content;
+    content << magic << " " << formatVersion << " " << rootKey << " " << digestType << "\n";
+
+    for (const auto& e : m_loaded)
+    {
+        const Entry& entry = e.second;
+
+        if (!entry.digest.empty()) { content << "D " << entry.mtime << " " << entry.size << " " << entry.digest << " " << e.first << "\n"; }
+        else { content << "P " << entry.mtime << " " << entry.size << " " << entry.partial.offset << " " << entry.partial.sha1State << " " << e.first << "\n"; }
+    }
+
+    replaceFile(m_file, content.str());
+
+    m_journal = openFile(m_file, "ab");
+    if (!m_journal) { throw fs::filesystem_error("failed to open checkpoint", m_file, std::error_code(errno, std::generic_category())); }
+}
+
+treesha1sum::Checkpoint::~Checkpoint()
+{
+    if (m_journal)
+    {
+        syncFile(m_journal);
+        std::fclose(m_journal);
+    }
+}
+
+bool treesha1sum::Checkpoint::findDone(const fs::path& path, int64_t mtime, uint64_t size, std::string& digest) const
+{
+    bool r = false;
+
+    const auto it = m_loaded.find(pathKey(path));
+
+    if ((it != m_loaded.end()) && !it->second.digest.empty() && (it->second.mtime == mtime) && (it->second.size == size))
+    {
+        digest = it->second.digest;
+        r = true;
+    }
+
+    return r;
+}
+
+bool treesha1sum::Checkpoint::findPartial(const fs::path& path, int64_t mtime, uint64_t size, Partial& partial) const
+{
+    bool r = false;
+
+    const auto it = m_loaded.find(pathKey(path));
+
+    if ((it != m_loaded.end()) && it->second.digest.empty() && (it->second.mtime == mtime) && (it->second.size == size))
+    {
+        partial = it->second.partial;
+        r = true;
+    }
+
+    return r;
+}
+
+void treesha1sum::Checkpoint::done(const fs::path& path, int64_t mtime, uint64_t size, const std::string& digest)
+{
+    m_append("D " + std::to_string(mtime) + " " + std::to_string(size) + " " + digest + " " + pathKey(path) + "\n");
+}
+
+void treesha1sum::Checkpoint::partial(const fs::path& path, int64_t mtime, uint64_t size, const Partial& partial)
+{
+    m_append("P " + std::to_string(mtime) + " " + std::to_string(size) + " " + std::to_string(partial.offset) + " " + partial.sha1State + " " + pathKey(path) +
+             "\n");
+}
+
+void treesha1sum::Checkpoint::finish()
+{
+    std::lock_guard<std::mutex> lg(m_mtx);
+
+    if (m_journal)
+    {
+        std::fclose(m_journal);
+        m_journal = nullptr;
+    }
+
+    fs::remove(m_file);
+}
+
+void treesha1sum::Checkpoint::m_load(const std::string& rootKey, const std::string& digestType)
+{
+    std::ifstream ifs(m_file, std::ios::binary);
+    if (!ifs.is_open()) { throw fs::filesystem_error("failed to open checkpoint", m_file, std::error_code(errno, std::generic_category())); }
+
+    const std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    size_t lineIdx = 0;
+    size_t pos = 0;
+    size_t end;
+
+    // the last line is ignored if it's not terminated, it has been cut off while writing
+    while ((end = data.find('\n', pos)) != std::string::npos)
+    {
+        std::istringstream line(data.substr(pos, end - pos));
+        pos = end + 1;
+
+        if (lineIdx++ == 0)
+        {
+            std::string m, root, type;
+            int version = 0;
+            line >> m >> version >> root >> type;
+
+            if (type.empty()) { type = "sha1"; } // written before git blob ids were supported
+
+            if ((m != magic) || (version != formatVersion)) { throw std::runtime_error("invalid checkpoint file: " + m_file.u8string()); }
+            if (root != rootKey) { throw std::runtime_error("the checkpoint has been created for a different root directory"); }
+            if (type != digestType) { throw std::runtime_error("the checkpoint has been created for a different digest type"); }
+
+            continue;
+        }
+
+        std::string type, key;
+        Entry entry {};
+        line >> type >> entry.mtime >> entry.size;
+
+        if (type == "D") { line >> entry.digest >> key; }
+        else if (type == "P") { line >> entry.partial.offset >> entry.partial.sha1State >> key; }
+
+        if (line.fail() || key.empty()) { continue; }
+
+        auto it = m_loaded.find(key);
+
+        // a completed entry can't be overwritten by an older partial one
+        if ((it == m_loaded.end()) || it->second.digest.empty() || !entry.digest.empty()) { m_loaded[key] = entry; }
+    }
+}
+
+void treesha1sum::Checkpoint::m_append(const std::string& line)
+{
+    std::lock_guard<std::mutex> lg(m_mtx);
+
+    if (m_journal)
+    {
+        writeFile(m_journal, m_file, line);
+
+        const auto now = std::chrono::steady_clock::now();
+
+        if ((now - m_lastFlush) >= m_interval)
+        {
+            m_flush();
+            m_lastFlush = now;
+        }
+    }
+}
+
+void treesha1sum::Checkpoint::m_flush() { syncFile(m_journal); }
+
+
+
+int64_t treesha1sum::mtimeOf(const fs::path& path)
+{
+    std::error_code ec;
+    const int64_t r = mtimeOf(path, ec);
+    if (ec) { throw fs::filesystem_error("failed to stat", path, ec); }
+
+    return r;
+}
+
+int64_t treesha1sum::mtimeOf(const fs::path& path, std::error_code& ec) noexcept
+{
+    int64_t r = 0;
+    ec.clear();
+
+#ifdef OMW_PLAT_WIN
+    // the file clock of MSVC counts 100 ns ticks since 1601-01-01
+    const auto t = fs::last_write_time(path, ec);
+    if (!ec) { r = ((int64_t)t.time_since_epoch().count() - 116444736000000000ll) * 100; }
+#else
+    struct stat st;
+
+    if (::stat(path.c_str(), &st) != 0) { ec = std::error_code(errno, std::generic_category()); }
+    else
+    {
+#ifdef __APPLE__
+        r = ((int64_t)st.st_mtimespec.tv_sec * 1000000000) + st.st_mtimespec.tv_nsec;
+#else
+        r = ((int64_t)st.st_mtim.tv_sec * 1000000000) + st.st_mtim.tv_nsec;
+#endif
+    }
+#endif
+
+    return r;
+}
+
+void treesha1sum::replaceFile(const fs::path& file, const std::string& content)
+{
+    fs::path tmpFile = file;
+    tmpFile += ".tmp";
+
+    std::FILE* tmp = openFile(tmpFile, "wb");
+    if (!tmp) { throw fs::filesystem_error("failed to create file", tmpFile, std::error_code(errno, std::generic_category())); }
+
+    try
+    {
+        writeFile(tmp, tmpFile, content);
+    }
+    catch (...)
+    {
+        std::fclose(tmp);
+        throw;
+    }
+
+    syncFile(tmp);
+    std::fclose(tmp);
+
+    fs::rename(tmpFile, file);
+}
+
+std::string treesha1sum::pathKey(const fs::path& path) { return hex::encode(path.lexically_normal().generic_u8string()); }
@@ -0,0 +1,111 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+    The checkpoint file is an append-only journal, one entry per line:
+
+        treesha1sum-checkpoint 1 <root> <digest type>
+        D <mtime> <size> <digest> <path>                the file has been hashed completely
+        P <mtime> <size> <offset> <SHA1 state> <path>   intermediate state of a large file at `offset`
+
+    Paths are hex encoded. A line is only valid once it's terminated by a newline, so a run killed while writing leaves
+    at most one incomplete line which is ignored on load. On resume the journal is compacted and rewritten atomically
+    (temporary file + rename).
+
+    The traversal itself is not journaled, re-enumerating the tree is cheap compared to hashing it. Entries are matched
+    by path, size and modification time, so files changed in between are hashed again.
+*/
+
+#ifndef IG_LIB_CHECKPOINT_H
+#define IG_LIB_CHECKPOINT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+
+namespace treesha1sum {
+
+class Checkpoint
+{
+public:
+    struct Partial
+    {
+        uint64_t offset;
+        std::string sha1State;
+    };
+
+public:
+    /**
+     * @param file Checkpoint file
+     * @param root Root of the walk, resuming a checkpoint of an other root fails
+     * @param digestType `sha1` or `git-blob`, resuming a checkpoint of an other type fails
+     * @param resume Load the checkpoint file if it exists, otherwise it's overwritten
+     * @param interval Max time between two flushes of the journal to the disk
+     */
+    Checkpoint(const std::filesystem::path& file, const std::filesystem::path& root, const std::string& digestType, bool resume,
+               std::chrono::seconds interval);
+    ~Checkpoint();
+
+    Checkpoint(const Checkpoint& other) = delete;
+    Checkpoint& operator=(const Checkpoint& other) = delete;
+
+    bool findDone(const std::filesystem::path& path, int64_t mtime, uint64_t size, std::string& digest) const;
+    bool findPartial(const std::filesystem::path& path, int64_t mtime, uint64_t size, Partial& partial) const;
+
+    // thread safe
+    void done(const std::filesystem::path& path, int64_t mtime, uint64_t size, const std::string& digest);
+    void partial(const std::filesystem::path& path, int64_t mtime, uint64_t size, const Partial& partial);
+
+    /**
+     * @brief Flushes the journal and deletes the checkpoint file. Called after the walk has completed.
+     */
+    void finish();
+
+private:
+    struct Entry
+    {
+        int64_t mtime;
+        uint64_t size;
+        std::string digest; // empty if partial
+        Partial partial;
+    };
+
+    std::filesystem::path m_file;
+    std::chrono::seconds m_interval;
+    std::map<std::string, Entry> m_loaded; // read only after construction
+    std::mutex m_mtx;
+    std::FILE* m_journal;
+    std::chrono::steady_clock::time_point m_lastFlush;
+
+    void m_load(const std::string& rootKey, const std::string& digestType);
+    void m_append(const std::string& line);
+    void m_flush();
+};
+
+// modification time in nanoseconds since the Unix epoch
+int64_t mtimeOf(const std::filesystem::path& path);
+int64_t mtimeOf(const std::filesystem::path& path, std::error_code& ec) noexcept;
+
+/**
+ * @brief Writes `content` to `<file>.tmp`, syncs it to the disk and renames it to `file`. An interrupted write never
+ * leaves a truncated `file`.
+ */
+void replaceFile(const std::filesystem::path& file, const std::string& content);
+
+// hex encoded normalized path, used as key in the checkpoint and incremental state files
+std::string pathKey(const std::filesystem::path& path);
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_CHECKPOINT_H
@@ -0,0 +1,118 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "filter.h"
+
+#include <omw/defs.h>
+
+#ifdef OMW_PLAT_WIN
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint32_t typeBit(fs::file_type type) { return ((uint32_t)1 << ((uint32_t)type & 0x1F)); }
+
+/**
+ * @brief ID of the filesystem (device or volume) containing `path`.
+ *
+ * @return `false` on error
+ */
+bool deviceOf(const fs::path& path, uint64_t& device)
+{
+    bool r = false;
+
+#ifdef OMW_PLAT_WIN
+    // FILE_FLAG_BACKUP_SEMANTICS is needed to open directories
+    const HANDLE h = ::CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                   FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+
+    if (h != INVALID_HANDLE_VALUE)
+    {
+        BY_HANDLE_FILE_INFORMATION info;
+
+        if (::GetFileInformationByHandle(h, &info))
+        {
+            device = info.dwVolumeSerialNumber;
+            r = true;
+        }
+
+        ::CloseHandle(h);
+    }
+#else
+    struct stat st;
+
+    if (::lstat(path.c_str(), &st) == 0)
+    {
+        device = (uint64_t)st.st_dev;
+        r = true;
+    }
+#endif
+
+    return r;
+}
+
+} // namespace
+
+
+
+treesha1sum::Filter::Filter(const Options& options, const fs::path& root)
+    : m_types(0),
+      m_sizeOrMtime(false),
+      m_needsMtime(false),
+      m_minSize(options.minSize),
+      m_maxSize(options.maxSize),
+      m_newerThan(options.newerThan),
+      m_olderThan(options.olderThan),
+      m_maxDepth(options.maxDepth),
+      m_oneFileSystem(options.oneFileSystem && !root.empty()),
+      m_rootDevice(0)
+{
+    for (const auto& type : options.types) { m_types |= typeBit(type); }
+    if (options.types.empty()) { m_types = UINT32_MAX; }
+
+    m_needsMtime = ((m_newerThan != INT64_MIN) || (m_olderThan != INT64_MAX));
+    m_sizeOrMtime = (m_needsMtime || (m_minSize != 0) || (m_maxSize != UINT64_MAX));
+
+    // an unknown root device disables the predicate, the error is reported by the walk
+    if (m_oneFileSystem && !deviceOf(root, m_rootDevice)) { m_oneFileSystem = false; }
+}
+
+bool treesha1sum::Filter::descend(const fs::path& dir, size_t depth) const
+{
+    bool r = (depth < m_maxDepth);
+
+    if (r && m_oneFileSystem)
+    {
+        uint64_t device;
+        r = (!deviceOf(dir, device) || (device == m_rootDevice));
+    }
+
+    return r;
+}
+
+bool treesha1sum::Filter::match(fs::file_type type, uint64_t size, int64_t mtime) const
+{
+    bool r = ((m_types & typeBit(type)) != 0);
+
+    if (r && m_sizeOrMtime)
+    {
+        r = ((type == fs::file_type::regular) && (size >= m_minSize) && (size <= m_maxSize) && (mtime > m_newerThan) && (mtime < m_olderThan));
+    }
+
+    return r;
+}
@@ -0,0 +1,67 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#ifndef IG_LIB_FILTER_H
+#define IG_LIB_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "treesha1sum.h"
+
+
+namespace treesha1sum {
+
+/**
+ * @brief The find-style predicates of `Options` (size, mtime, type, depth and filesystem), compiled once per walk.
+ *
+ * The predicates are evaluated on the metadata the walk reads anyway, before a file is opened or a directory is
+ * entered. Entries which don't match are neither reported nor read.
+ */
+class Filter
+{
+public:
+    /**
+     * @param root Root of the walk, only needed for `Options::oneFileSystem`
+     */
+    explicit Filter(const Options& options, const std::filesystem::path& root = std::filesystem::path());
+
+    /**
+     * @brief Whether `match()` needs the mtime, so that it's only read if it's used.
+     */
+    bool needsMtime() const { return m_needsMtime; }
+
+    /**
+     * @param depth Directory levels of `dir` below the root, 0 for the root itself
+     * @return `false` if the entries of the directory are not to be walked
+     */
+    bool descend(const std::filesystem::path& dir, size_t depth) const;
+
+    /**
+     * @brief Size and mtime predicates only match regular files, other entries have no size and mtime in the records.
+     */
+    bool match(std::filesystem::file_type type, uint64_t size, int64_t mtime) const;
+
+    bool match(const Record& record) const { return match(record.type, record.size, record.mtime); }
+
+private:
+    uint32_t m_types; // bit mask of `fs::file_type` values
+    bool m_sizeOrMtime;
+    bool m_needsMtime;
+    uint64_t m_minSize;
+    uint64_t m_maxSize;
+    int64_t m_newerThan;
+    int64_t m_olderThan;
+    size_t m_maxDepth;
+    bool m_oneFileSystem;
+    uint64_t m_rootDevice;
+};
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_FILTER_H
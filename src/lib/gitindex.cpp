@@ -0,0 +1,460 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "gitindex.h"
+#include "middleware/hex.h"
+
+#include <omw/defs.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t hashSize = 20;       // SHA-1, SHA-256 repositories are not supported
+constexpr size_t entryFixedSize = 62; // stat data, hash and flags
+
+constexpr uint16_t flagExtended = 0x4000;
+constexpr uint16_t flagStageMask = 0x3000;
+constexpr uint16_t extFlagSkipWorktree = 0x4000;
+constexpr uint16_t extFlagIntentToAdd = 0x2000;
+
+constexpr uint32_t modeTypeMask = 0170000;
+constexpr uint32_t modeRegular = 0100000;
+
+uint32_t be32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+uint16_t be16(const uint8_t* p) { return (uint16_t)(((uint16_t)p[0] << 8) | p[1]); }
+
+std::string readFile(const fs::path& file)
+{
+    std::ifstream ifs(file, std::ios::binary);
+    if (!ifs.is_open()) { throw fs::filesystem_error("failed to open", file, std::error_code(errno, std::generic_category())); }
+
+    return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+std::string firstLine(const fs::path& file)
+{
+    std::string r = readFile(file);
+    r.erase(std::min(r.find('\n'), r.size()));
+    if (!r.empty() && (r.back() == '\r')) { r.pop_back(); }
+
+    return r;
+}
+
+std::string toLower(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](char c) { return (char)(((c >= 'A') && (c <= 'Z')) ? (c - 'A' + 'a') : c); });
+    return str;
+}
+
+std::string trim(const std::string& str)
+{
+    const size_t begin = str.find_first_not_of(" \t\r");
+    return ((begin == std::string::npos) ? std::string() : str.substr(begin, str.find_last_not_of(" \t\r") - begin + 1));
+}
+
+fs::path envPath(const char* name)
+{
+    fs::path r;
+
+#ifdef OMW_PLAT_WIN
+    char* value = nullptr;
+    size_t len = 0;
+
+    if ((::_dupenv_s(&value, &len, name) == 0) && value)
+    {
+        r = fs::u8path(value);
+        std::free(value);
+    }
+#else
+    const char* const value = std::getenv(name);
+    if (value) { r = value; }
+#endif
+
+    return r;
+}
+
+/**
+ * @brief Reads the values of a git config file into `values` (`section.key` -> value, lower case), overrides existing values.
+ *
+ * Subsections are kept (`filter.lfs.clean`), keys without value are `true`. Includes are not followed.
+ */
+void readConfig(const fs::path& file, std::unordered_map<std::string, std::string>& values)
+{
+    std::error_code ec;
+    if (!fs::is_regular_file(file, ec)) { return; }
+
+    std::istringstream iss(readFile(file));
+    std::string line;
+    std::string section;
+
+    while (std::getline(iss, line))
+    {
+        line = trim(line);
+
+        if (line.empty() || (line[0] == '#') || (line[0] == ';')) { continue; }
+
+        if (line[0] == '[')
+        {
+            const size_t end = line.find(']');
+            std::string str = line.substr(1, ((end == std::string::npos) ? line.size() : end) - 1);
+
+            // [section "subsection"] => section.subsection
+            const size_t quote = str.find('"');
+            if (quote != std::string::npos) { str = trim(str.substr(0, quote)) + "." + str.substr(quote + 1, str.rfind('"') - quote - 1); }
+
+            section = toLower(trim(str));
+            line = ((end == std::string::npos) ? std::string() : trim(line.substr(end + 1))); // `[core] autocrlf = true` is valid
+            if (line.empty()) { continue; }
+        }
+
+        const size_t eq = line.find('=');
+        const std::string key = toLower(trim(line.substr(0, eq)));
+        std::string value = ((eq == std::string::npos) ? std::string("true") : trim(line.substr(eq + 1)));
+
+        const size_t comment = value.find_first_of("#;");
+        if (comment != std::string::npos) { value = trim(value.substr(0, comment)); }
+        if ((value.size() >= 2) && (value.front() == '"') && (value.back() == '"')) { value = value.substr(1, value.size() - 2); }
+
+        values[section + "." + key] = toLower(value);
+    }
+}
+
+bool isTrue(const std::string& value) { return ((value == "true") || (value == "yes") || (value == "on") || (value == "1")); }
+
+/**
+ * @brief Whether a gitattributes file sets an attribute which converts the content when it's added to the index.
+ *
+ * `text`, `eol`, `crlf`, `filter`, `ident` and `working-tree-encoding` are detected regardless of the patterns, unset
+ * attributes (`-text`, `!text`) don't convert.
+ */
+bool hasConvertingAttributes(const fs::path& file)
+{
+    std::error_code ec;
+    if (!fs::is_regular_file(file, ec)) { return false; }
+
+    std::istringstream iss(readFile(file));
+    std::string line;
+
+    while (std::getline(iss, line))
+    {
+        std::istringstream tokens(line);
+        std::string token;
+
+        if (!(tokens >> token) || (token[0] == '#')) { continue; } // the first token is the pattern or a macro name
+
+        while (tokens >> token)
+        {
+            if ((token[0] == '-') || (token[0] == '!')) { continue; }
+
+            const std::string name = token.substr(0, token.find('='));
+
+            if ((name == "text") || (name == "eol") || (name == "crlf") || (name == "filter") || (name == "ident") || (name == "working-tree-encoding"))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Finds the git directory of the working tree containing `dir`, supports `.git` files (`gitdir: <path>`).
+ */
+fs::path findGitDir(const fs::path& dir, fs::path& workTree)
+{
+    fs::path p = fs::absolute(dir).lexically_normal();
+
+    while (true)
+    {
+        const fs::path dotGit = p / ".git";
+
+        if (fs::is_directory(dotGit))
+        {
+            workTree = p;
+            return dotGit;
+        }
+        else if (fs::is_regular_file(dotGit))
+        {
+            const std::string content = firstLine(dotGit);
+            const std::string prefix = "gitdir: ";
+            if (content.compare(0, prefix.size(), prefix) != 0) { throw std::runtime_error("invalid .git file: " + dotGit.u8string()); }
+
+            workTree = p;
+            return (p / fs::u8path(content.substr(prefix.size()))).lexically_normal();
+        }
+
+        if (!p.has_relative_path()) { break; }
+        p = p.parent_path();
+    }
+
+    throw std::runtime_error("not inside a git working tree: " + dir.u8string());
+}
+
+} // namespace
+
+
+
+std::string treesha1sum::gitBlobHeader(uint64_t size) { return "blob " + std::to_string(size) + std::string(1, '\0'); }
+
+treesha1sum::GitIndex::GitIndex(const fs::path& dir)
+    : m_workTree(), m_indexMtime(), m_entries(), m_converting(false), m_attrMtx(), m_attrDirs()
+{
+    const fs::path gitDir = findGitDir(dir, m_workTree);
+
+    // linked worktrees share the config of the main repository
+    fs::path commonDir = gitDir;
+    if (fs::is_regular_file(gitDir / "commondir")) { commonDir = (gitDir / fs::u8path(firstLine(gitDir / "commondir"))).lexically_normal(); }
+
+    // system, global and repository config, in increasing priority
+    std::unordered_map<std::string, std::string> config;
+    fs::path home = envPath("HOME");
+    fs::path xdgConfig = envPath("XDG_CONFIG_HOME");
+
+#ifdef OMW_PLAT_WIN
+    if (home.empty()) { home = envPath("USERPROFILE"); }
+    readConfig(envPath("PROGRAMDATA") / "Git" / "config", config);
+    readConfig(envPath("PROGRAMFILES") / "Git" / "etc" / "gitconfig", config);
+#else
+    readConfig("/etc/gitconfig", config);
+#endif
+
+    if (xdgConfig.empty() && !home.empty()) { xdgConfig = home / ".config"; }
+    if (!xdgConfig.empty()) { readConfig(xdgConfig / "git" / "config", config); }
+    if (!home.empty()) { readConfig(home / ".gitconfig", config); }
+    readConfig(commonDir / "config", config);
+
+    if (config["extensions.objectformat"] == "sha256") { throw std::runtime_error("SHA-256 git repositories are not supported"); }
+
+    // the index contains the ids of the converted content, the files have to be hashed if any conversion may apply
+    fs::path attributesFile = (xdgConfig.empty() ? fs::path() : (xdgConfig / "git" / "attributes"));
+    if (!config["core.attributesfile"].empty()) { attributesFile = fs::u8path(config["core.attributesfile"]); }
+
+    m_converting = (isTrue(config["core.autocrlf"]) || (config["core.autocrlf"] == "input") || (config["core.eol"] == "crlf") ||
+                    hasConvertingAttributes(commonDir / "info" / "attributes") || (!attributesFile.empty() && hasConvertingAttributes(attributesFile)));
+
+    m_load(gitDir);
+}
+
+bool treesha1sum::GitIndex::lookup(const fs::path& path, uint64_t size, std::string& blobId) const
+{
+    bool r = false;
+
+    const std::string key = fs::absolute(path).lexically_normal().lexically_relative(m_workTree).generic_u8string();
+    const auto it = m_entries.find(key);
+
+    if ((it != m_entries.end()) && !m_converting && !m_hasConvertingAttributes(key))
+    {
+        const Entry& entry = it->second;
+        Entry st;
+
+        // an entry with a timestamp not older than the index may have been modified right after it was hashed
+        const bool racy = ((entry.mtime.sec > m_indexMtime.sec) || ((entry.mtime.sec == m_indexMtime.sec) && (entry.mtime.nsec >= m_indexMtime.nsec)));
+
+        if (!racy && (entry.size == (uint32_t)size) && m_stat(path, st) && (st.size == entry.size) && (st.mtime.sec == entry.mtime.sec))
+        {
+#ifdef OMW_PLAT_WIN
+            // only mtime seconds and size, like `core.checkStat = minimal`
+            r = true;
+#else
+            r = ((st.mtime.nsec == entry.mtime.nsec) && (st.ctime.sec == entry.ctime.sec) && (st.ctime.nsec == entry.ctime.nsec) && (st.ino == entry.ino));
+#endif
+        }
+
+        if (r) { blobId = entry.blobId; }
+    }
+
+    return r;
+}
+
+bool treesha1sum::GitIndex::m_hasConvertingAttributes(const std::string& key) const
+{
+    bool r = false;
+    std::string dir;
+    size_t pos = 0;
+
+    // `.gitattributes` of the working tree root and of all parent directories of the file
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lg(m_attrMtx);
+
+            const auto it = m_attrDirs.find(dir);
+
+            if (it != m_attrDirs.end()) { r = it->second; }
+            else
+            {
+                r = hasConvertingAttributes(m_workTree / fs::u8path(dir) / ".gitattributes");
+                m_attrDirs[dir] = r;
+            }
+        }
+
+        pos = key.find('/', pos);
+        if (r || (pos == std::string::npos)) { break; }
+
+        dir = key.substr(0, pos);
+        ++pos;
+    }
+
+    return r;
+}
+
+bool treesha1sum::GitIndex::m_stat(const fs::path& path, Entry& entry)
+{
+    bool r = false;
+
+#ifdef OMW_PLAT_WIN
+    struct _stat64 st;
+
+    if (::_wstat64(path.c_str(), &st) == 0)
+    {
+        entry.ctime = { (uint32_t)st.st_ctime, 0 };
+        entry.mtime = { (uint32_t)st.st_mtime, 0 };
+        entry.ino = 0;
+        entry.size = (uint32_t)st.st_size;
+        r = true;
+    }
+#else
+    struct stat st;
+
+    if (::stat(path.c_str(), &st) == 0)
+    {
+#ifdef __APPLE__
+        entry.ctime = { (uint32_t)st.st_ctimespec.tv_sec, (uint32_t)st.st_ctimespec.tv_nsec };
+        entry.mtime = { (uint32_t)st.st_mtimespec.tv_sec, (uint32_t)st.st_mtimespec.tv_nsec };
+#else
+        entry.ctime = { (uint32_t)st.st_ctim.tv_sec, (uint32_t)st.st_ctim.tv_nsec };
+        entry.mtime = { (uint32_t)st.st_mtim.tv_sec, (uint32_t)st.st_mtim.tv_nsec };
+#endif
+        entry.ino = (uint32_t)st.st_ino;
+        entry.size = (uint32_t)st.st_size;
+        r = true;
+    }
+#endif
+
+    return r;
+}
+
+void treesha1sum::GitIndex::m_load(const fs::path& gitDir)
+{
+    const fs::path file = gitDir / "index";
+    const std::string str = readFile(file);
+    const uint8_t* const data = (const uint8_t*)str.data();
+
+    Entry indexStat;
+    if (!m_stat(file, indexStat)) { throw fs::filesystem_error("failed to stat", file, std::error_code(errno, std::generic_category())); }
+    m_indexMtime = indexStat.mtime;
+
+    const std::runtime_error invalid("invalid git index: " + file.u8string());
+
+    if ((str.size() < (12 + hashSize)) || (std::memcmp(data, "DIRC", 4) != 0)) { throw invalid; }
+
+    const uint32_t version = be32(data + 4);
+    const uint32_t count = be32(data + 8);
+    const size_t end = str.size() - hashSize; // trailing checksum
+
+    if ((version < 2) || (version > 4)) { throw std::runtime_error("unsupported git index version " + std::to_string(version)); }
+
+    size_t pos = 12;
+    std::string path;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const size_t entryBegin = pos;
+        if ((pos + entryFixedSize) > end) { throw invalid; }
+
+        const uint8_t* const p = data + pos;
+
+        Entry entry;
+        entry.ctime = { be32(p), be32(p + 4) };
+        entry.mtime = { be32(p + 8), be32(p + 12) };
+        entry.ino = be32(p + 20);
+        const uint32_t mode = be32(p + 24);
+        entry.size = be32(p + 36);
+        entry.blobId = hex::encode(p + 40, hashSize);
+        const uint16_t flags = be16(p + 60);
+        uint16_t extFlags = 0;
+
+        pos += entryFixedSize;
+
+        if (flags & flagExtended)
+        {
+            if ((version < 3) || ((pos + 2) > end)) { throw invalid; }
+            extFlags = be16(data + pos);
+            pos += 2;
+        }
+
+        if (version == 4)
+        {
+            // prefix compression: number of bytes to remove from the previous path, followed by the NUL terminated suffix
+            if (pos >= end) { throw invalid; }
+
+            uint8_t c = data[pos++];
+            size_t strip = c & 0x7F;
+
+            while (c & 0x80)
+            {
+                if (pos >= end) { throw invalid; }
+
+                c = data[pos++];
+                strip = ((strip + 1) << 7) | (c & 0x7F);
+            }
+
+            if (strip > path.size()) { throw invalid; }
+
+            const uint8_t* const nul = (const uint8_t*)std::memchr(data + pos, 0, end - pos);
+            if (!nul) { throw invalid; }
+
+            path.erase(path.size() - strip);
+            path.append((const char*)(data + pos), (size_t)(nul - (data + pos)));
+            pos = (size_t)(nul - data) + 1;
+        }
+        else
+        {
+            const uint8_t* const nul = (const uint8_t*)std::memchr(data + pos, 0, end - pos);
+            if (!nul) { throw invalid; }
+
+            path.assign((const char*)(data + pos), (size_t)(nul - (data + pos)));
+
+            // the entry is padded with 1-8 NUL bytes to a multiple of 8
+            pos = entryBegin + ((((size_t)(nul - data) - entryBegin) + 8) & ~(size_t)7);
+            if (pos > end) { throw invalid; }
+        }
+
+        const bool tracked = (((flags & flagStageMask) == 0) && ((extFlags & (extFlagSkipWorktree | extFlagIntentToAdd)) == 0));
+
+        if (tracked && ((mode & modeTypeMask) == modeRegular)) { m_entries[path] = entry; }
+    }
+
+    // extensions, a split index only contains the changes to the shared index
+    while ((pos + 8) <= end)
+    {
+        if (std::memcmp(data + pos, "link", 4) == 0) { throw std::runtime_error("split git indexes are not supported"); }
+
+        pos += 8 + (size_t)be32(data + pos + 4);
+    }
+}
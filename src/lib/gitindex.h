@@ -0,0 +1,84 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#ifndef IG_LIB_GITINDEX_H
+#define IG_LIB_GITINDEX_H
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace treesha1sum {
+
+/**
+ * @brief Header which is hashed before the content to get the git blob id (`git hash-object`) of a file.
+ */
+std::string gitBlobHeader(uint64_t size);
+
+/**
+ * @brief Blob ids and stat data of the tracked files, read from `.git/index` (versions 2, 3 and 4).
+ *
+ * Only stage 0 regular file entries are loaded, skip-worktree and intent-to-add entries are ignored. Like git, an
+ * entry is only trusted if it's not racily clean, i.e. the file has been modified before the index was written.
+ * Split indexes and SHA-256 repositories are not supported (`std::runtime_error`).
+ *
+ * The blob ids of the index are of the content after the clean conversion (line endings, filters like LFS). They are
+ * not used if a conversion may apply to a file: `core.autocrlf`, `core.eol=crlf`, or a `text`, `eol`, `crlf`,
+ * `filter`, `ident` or `working-tree-encoding` attribute in any gitattributes file which may affect the file. The
+ * detection is conservative, the patterns of the attributes are not evaluated.
+ */
+class GitIndex
+{
+public:
+    /**
+     * @param dir A directory inside the working tree, the repository is searched upwards from there
+     */
+    explicit GitIndex(const std::filesystem::path& dir);
+
+    /**
+     * @brief Gets the blob id of a tracked file whose stat data still matches the index entry.
+     *
+     * @return `false` if the file is not tracked or may have been modified, the content has to be read then
+     */
+    bool lookup(const std::filesystem::path& path, uint64_t size, std::string& blobId) const;
+
+private:
+    struct Timestamp
+    {
+        uint32_t sec;
+        uint32_t nsec;
+    };
+
+    struct Entry
+    {
+        Timestamp ctime;
+        Timestamp mtime;
+        uint32_t ino;
+        uint32_t size; // truncated to 32 bit by git
+        std::string blobId;
+    };
+
+    std::filesystem::path m_workTree; // absolute
+    Timestamp m_indexMtime;
+    std::unordered_map<std::string, Entry> m_entries; // path relative to the working tree -> entry
+    bool m_converting;                                // a conversion may apply to all files
+
+    mutable std::mutex m_attrMtx;
+    mutable std::unordered_map<std::string, bool> m_attrDirs; // directory relative to the working tree -> has converting `.gitattributes`
+
+    bool m_hasConvertingAttributes(const std::string& key) const;
+    void m_load(const std::filesystem::path& gitDir);
+
+    static bool m_stat(const std::filesystem::path& path, Entry& entry);
+};
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_GITINDEX_H
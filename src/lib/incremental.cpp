@@ -0,0 +1,166 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "checkpoint.h"
+#include "incremental.h"
+#include "middleware/hex.h"
+#include "middleware/sha1.h"
+
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const magic = "treesha1sum-incremental";
+const int formatVersion = 1;
+
+constexpr uint64_t fingerprintSize = 4096;
+
+/**
+ * @brief SHA1 of the last `fingerprintSize` bytes before `offset`, empty if they can't be read.
+ */
+std::string tailFingerprint(const fs::path& path, uint64_t offset)
+{
+    std::string r;
+
+    const uint64_t begin = offset - std::min(offset, fingerprintSize);
+    std::vector<uint8_t> buffer((size_t)(offset - begin));
+
+    std::ifstream fstream(path, std::ios::binary);
+
+    if (fstream.is_open() && fstream.seekg((std::streamoff)begin) && fstream.read((char*)buffer.data(), (std::streamsize)buffer.size()))
+    {
+        SHA1 sha1;
+        sha1.update(buffer.data(), buffer.size());
+        r = sha1.digest();
+    }
+
+    return r;
+}
+
+} // namespace
+
+
+
+treesha1sum::IncrementalState::IncrementalState(const fs::path& file, uint64_t minSize)
+    : m_file(file), m_minSize(minSize), m_loaded(), m_mtx(), m_updated()
+{
+    if (fs::exists(m_file)) { m_load(); }
+}
+
+uint64_t treesha1sum::IncrementalState::resume(const fs::path& path, int64_t mtime, uint64_t size, SHA1& sha1) const
+{
+    uint64_t offset = 0;
+
+    const auto it = m_loaded.find(pathKey(path));
+
+    if (it != m_loaded.end())
+    {
+        const Entry& entry = it->second;
+
+        const bool unchanged = ((entry.size == size) && (entry.mtime == mtime));
+        const bool appended = ((entry.size < size) && (tailFingerprint(path, entry.size) == entry.fingerprint));
+
+        if ((unchanged || appended) && sha1.importState(entry.sha1State)) { offset = entry.size; }
+    }
+
+    return offset;
+}
+
+void treesha1sum::IncrementalState::update(const fs::path& path, int64_t mtime, uint64_t size, const SHA1& sha1)
+{
+    Entry entry {}; // an entry without state removes the file from the state file
+
+    if (size >= m_minSize)
+    {
+        // the file is only stored if it didn't change while it was hashed, a failed stat skips it
+        std::error_code ec;
+        const uint64_t currentSize = fs::file_size(path, ec);
+        const int64_t currentMtime = (ec ? 0 : mtimeOf(path, ec));
+
+        if (!ec && (currentSize == size) && (currentMtime == mtime))
+        {
+            entry = { mtime, size, tailFingerprint(path, size), sha1.exportState() };
+            if (entry.fingerprint.empty()) { entry.sha1State.clear(); }
+        }
+    }
+
+    std::lock_guard<std::mutex> lg(m_mtx);
+    m_updated[pathKey(path)] = entry;
+}
+
+void treesha1sum::IncrementalState::save() const
+{
+    std::ostringstream content;
+    content << magic << " " << formatVersion << "\n";
+
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+
+        std::map<std::string, Entry> entries = m_updated;
+
+        for (const auto& e : m_loaded)
+        {
+            std::string path;
+            std::error_code ec;
+
+            if ((entries.count(e.first) == 0) && hex::decode(e.first, path) && fs::is_regular_file(fs::u8path(path), ec)) { entries.insert(e); }
+        }
+
+        for (const auto& e : entries)
+        {
+            const Entry& entry = e.second;
+            if (entry.sha1State.empty()) { continue; }
+
+            content << entry.mtime << " " << entry.size << " " << entry.fingerprint << " " << entry.sha1State << " " << e.first << "\n";
+        }
+    }
+
+    replaceFile(m_file, content.str());
+}
+
+void treesha1sum::IncrementalState::m_load()
+{
+    std::ifstream ifs(m_file, std::ios::binary);
+    if (!ifs.is_open()) { throw fs::filesystem_error("failed to open incremental state", m_file, std::error_code(errno, std::generic_category())); }
+
+    std::string line;
+
+    if (std::getline(ifs, line))
+    {
+        std::istringstream header(line);
+        std::string m;
+        int version = 0;
+        header >> m >> version;
+
+        if ((m != magic) || (version != formatVersion)) { throw std::runtime_error("invalid incremental state file: " + m_file.u8string()); }
+    }
+
+    while (std::getline(ifs, line))
+    {
+        std::istringstream iss(line);
+        std::string key;
+        Entry entry {};
+
+        iss >> entry.mtime >> entry.size >> entry.fingerprint >> entry.sha1State >> key;
+
+        if (!iss.fail() && !key.empty()) { m_loaded[key] = entry; }
+    }
+}
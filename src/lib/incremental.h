@@ -0,0 +1,91 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+    The incremental state file keeps the intermediate SHA1 state of large files between runs, one entry per line:
+
+        treesha1sum-incremental 1
+        <mtime> <size> <tail fingerprint> <SHA1 state> <path>
+
+    The SHA1 state is taken at the end of the file (before the final padding), the tail fingerprint is the SHA1 of the
+    last 4 KiB before `size`. Paths are hex encoded.
+
+    On the next run a file with the same size and modification time is not read at all. A file which has grown is
+    assumed to be appended to if the bytes before the old size still match the tail fingerprint, only the new tail is
+    read then. Modifications before the last 4 KiB of the old content are NOT detected in this case, the mode is meant
+    for append-only files like logs. Everything else (truncated, rotated, fingerprint mismatch) is hashed completely.
+*/
+
+#ifndef IG_LIB_INCREMENTAL_H
+#define IG_LIB_INCREMENTAL_H
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "middleware/sha1.h"
+
+
+namespace treesha1sum {
+
+class IncrementalState
+{
+public:
+    /**
+     * @param file State file, it's loaded if it exists
+     * @param minSize The state of smaller files is not stored
+     */
+    IncrementalState(const std::filesystem::path& file, uint64_t minSize);
+
+    IncrementalState(const IncrementalState& other) = delete;
+    IncrementalState& operator=(const IncrementalState& other) = delete;
+
+    /**
+     * @brief Restores the stored state of the file into `sha1` if it can be continued.
+     *
+     * @return Offset at which hashing continues, 0 if there is no usable state (`sha1` is not modified then)
+     */
+    uint64_t resume(const std::filesystem::path& path, int64_t mtime, uint64_t size, SHA1& sha1) const;
+
+    /**
+     * @brief Stores the state of a completely hashed file, `sha1` must not be finalized yet. Thread safe.
+     *
+     * Nothing is stored if the file has been changed while it was hashed.
+     */
+    void update(const std::filesystem::path& path, int64_t mtime, uint64_t size, const SHA1& sha1);
+
+    /**
+     * @brief Atomically replaces the state file (temporary file + rename).
+     *
+     * Entries of files which have not been hashed in this run are kept as long as the files exist, so that walking
+     * a sub tree or a file list does not drop the state of the others.
+     */
+    void save() const;
+
+private:
+    struct Entry
+    {
+        int64_t mtime;
+        uint64_t size;
+        std::string fingerprint;
+        std::string sha1State;
+    };
+
+    std::filesystem::path m_file;
+    uint64_t m_minSize;
+    std::map<std::string, Entry> m_loaded; // read only after construction
+    mutable std::mutex m_mtx;
+    std::map<std::string, Entry> m_updated;
+
+    void m_load();
+};
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_INCREMENTAL_H
@@ -0,0 +1,525 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "checkpoint.h"
+#include "manifest.h"
+#include "middleware/hex.h"
+#include "middleware/sha1.h"
+#include "reader.h"
+#include "treesha1sum.h"
+
+
+namespace fs = std::filesystem;
+
+using treesha1sum::BinaryManifest;
+using treesha1sum::BinaryManifestWriter;
+using treesha1sum::Record;
+
+namespace {
+
+const char magic[8] = { 't', 'r', 'e', 'e', 's', 'h', 'a', '1' };
+constexpr uint32_t formatVersion = 1;
+constexpr uint32_t blockEntries = 16;
+constexpr size_t headerSize = 80;
+
+constexpr uint8_t infoTypeMask = 0x0F;
+constexpr uint8_t infoQuick = 0x80;
+
+// stable on-disk values of the file types
+const fs::file_type fileTypes[] = {
+    fs::file_type::none,  fs::file_type::not_found, fs::file_type::regular, fs::file_type::directory, fs::file_type::symlink,
+    fs::file_type::block, fs::file_type::character, fs::file_type::fifo,    fs::file_type::socket,    fs::file_type::unknown,
+};
+constexpr size_t nFileTypes = sizeof(fileTypes) / sizeof(fileTypes[0]);
+
+uint8_t typeToByte(fs::file_type type)
+{
+    const auto it = std::find(std::begin(fileTypes), std::end(fileTypes), type);
+    return (uint8_t)((it != std::end(fileTypes)) ? (it - std::begin(fileTypes)) : (nFileTypes - 1)); // implementation-defined => unknown
+}
+
+void put32(std::string& buffer, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) { buffer += (char)(uint8_t)(value >> (8 * i)); }
+}
+
+void put64(std::string& buffer, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) { buffer += (char)(uint8_t)(value >> (8 * i)); }
+}
+
+void putVarint(std::string& buffer, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer += (char)(uint8_t)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+
+    buffer += (char)(uint8_t)value;
+}
+
+uint32_t get32(const uint8_t* p)
+{
+    uint32_t r = 0;
+    for (int i = 3; i >= 0; --i) { r = (r << 8) | p[i]; }
+    return r;
+}
+
+uint64_t get64(const uint8_t* p)
+{
+    uint64_t r = 0;
+    for (int i = 7; i >= 0; --i) { r = (r << 8) | p[i]; }
+    return r;
+}
+
+// escalated files have a quick-scan fingerprint and a SHA1 entry, the fingerprint is kept for the comparison of the next quick scan
+void addDigest(treesha1sum::DigestMap& map, const std::string& path, const std::string& digest)
+{
+    const bool quick = (digest.compare(0, std::strlen(treesha1sum::quickPrefix), treesha1sum::quickPrefix) == 0);
+    if (quick || (map.count(path) == 0)) { map[path] = digest; }
+}
+
+std::runtime_error invalidManifest(const fs::path& file) { return std::runtime_error("invalid binary manifest: " + file.u8string()); }
+
+} // namespace
+
+
+
+/**
+ * @brief Sequential decoder of the path section, starting at the beginning of a block.
+ */
+class treesha1sum::BinaryManifest::Cursor
+{
+public:
+    Cursor(const uint8_t* begin, const uint8_t* end, const uint8_t* info, uint64_t index, uint64_t count)
+        : m_pos(begin), m_end(end), m_info(info), m_index(index), m_count(count), m_path(), m_target()
+    {
+        if (valid()) { m_decode(); }
+    }
+
+    bool valid() const { return (m_index < m_count); }
+    uint64_t index() const { return m_index; }
+    const std::string& path() const { return m_path; }
+    const std::string& symlinkTarget() const { return m_target; }
+
+    void next()
+    {
+        ++m_index;
+        if (valid()) { m_decode(); }
+    }
+
+private:
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+    const uint8_t* m_info;
+    uint64_t m_index;
+    uint64_t m_count;
+    std::string m_path;
+    std::string m_target;
+
+    uint64_t m_varint()
+    {
+        uint64_t r = 0;
+
+        for (int shift = 0; (m_pos < m_end) && (shift < 64); shift += 7)
+        {
+            const uint8_t b = *(m_pos++);
+            r |= (uint64_t)(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) { return r; }
+        }
+
+        throw std::runtime_error("invalid binary manifest path section");
+    }
+
+    // replaces everything after the first `keep` bytes of `str`
+    void m_string(std::string& str, uint64_t keep)
+    {
+        const uint64_t len = m_varint();
+        if ((keep > str.size()) || (len > (uint64_t)(m_end - m_pos))) { throw std::runtime_error("invalid binary manifest path section"); }
+
+        str.erase((size_t)keep);
+        str.append((const char*)m_pos, (size_t)len);
+        m_pos += len;
+    }
+
+    void m_decode()
+    {
+        m_string(m_path, m_varint());
+
+        if (fileTypes[std::min<size_t>(m_info[m_index] & infoTypeMask, nFileTypes - 1)] == fs::file_type::symlink) { m_string(m_target, 0); }
+        else { m_target.clear(); }
+    }
+};
+
+
+
+bool treesha1sum::parseManifestLine(const std::string& line, std::string& digest, std::string& path)
+{
+    bool r = false;
+
+    std::string tmp = line;
+    if (!tmp.empty() && (tmp.back() == '\r')) { tmp.pop_back(); }
+
+    const size_t sep = tmp.find(' ');
+
+    if (!tmp.empty() && (tmp[0] != '[') && (sep != std::string::npos) && (sep > 0) && ((sep + 2) < tmp.size()))
+    {
+        // binary mode marker `*` or text mode marker ` `
+        if ((tmp[sep + 1] == '*') || (tmp[sep + 1] == ' '))
+        {
+            digest = tmp.substr(0, sep);
+            path = tmp.substr(sep + 2);
+            r = true;
+        }
+    }
+
+    return r;
+}
+
+bool treesha1sum::parseManifestLine(const std::string& line, Record& record)
+{
+    bool r = false;
+    std::string digest, path;
+
+    if (parseManifestLine(line, digest, path))
+    {
+        record = Record();
+        record.path = fs::u8path(path);
+        record.type = fs::file_type::regular;
+
+        if (digest.compare(0, std::strlen(quickPrefix), quickPrefix) == 0)
+        {
+            record.digest = digest.substr(std::strlen(quickPrefix));
+            record.quick = true;
+        }
+        else { record.digest = digest; }
+
+        r = true;
+    }
+    else if (!line.empty() && (line[0] == '['))
+    {
+        std::string tmp = line;
+        if (!tmp.empty() && (tmp.back() == '\r')) { tmp.pop_back(); }
+
+        const size_t close = tmp.find(']');
+        const size_t pathPos = std::max<size_t>(SHA1::digestSize * 2, close + 1) + 2; // see `manifestLine()`
+
+        if ((close != std::string::npos) && (pathPos < tmp.size()))
+        {
+            const std::string typeStr = tmp.substr(1, close - 1);
+            const auto it = std::find_if(std::begin(fileTypes), std::end(fileTypes), [&](fs::file_type t) { return (toString(t) == typeStr); });
+
+            if (it != std::end(fileTypes))
+            {
+                record = Record();
+                record.type = *it;
+                path = tmp.substr(pathPos);
+
+                const size_t arrow = path.find(" -> ");
+
+                if ((record.type == fs::file_type::symlink) && (arrow != std::string::npos))
+                {
+                    record.symlinkTarget = fs::u8path(path.substr(arrow + 4));
+                    path.erase(arrow);
+                }
+
+                record.path = fs::u8path(path);
+                r = true;
+            }
+        }
+    }
+
+    return r;
+}
+
+std::string treesha1sum::manifestLine(const Record& record)
+{
+    std::ostringstream line;
+
+    if (record.type == fs::file_type::regular) { line << digestStr(record) << " *" << pathStr(record.path); }
+    else
+    {
+        line << std::left << std::setw(SHA1::digestSize * 2) << ("[" + toString(record.type) + "]") << std::right;
+
+        if (record.type == fs::file_type::symlink) { line << "  " << pathStr(record.path) << " -> " << pathStr(record.symlinkTarget); }
+        else { line << "  " << pathStr(record.path); }
+    }
+
+    return line.str();
+}
+
+treesha1sum::DigestMap treesha1sum::loadManifest(const fs::path& file)
+{
+    DigestMap r;
+
+    if (isBinaryManifest(file))
+    {
+        const BinaryManifest manifest(file);
+
+        manifest.forEach("", [&](const Record& record) {
+            if (record.type == fs::file_type::regular) { addDigest(r, pathStr(record.path), digestStr(record)); }
+        });
+    }
+    else { r = loadTextManifest(file); }
+
+    return r;
+}
+
+treesha1sum::DigestMap treesha1sum::loadTextManifest(const fs::path& file)
+{
+    DigestMap r;
+
+    std::ifstream ifs(file, std::ios::binary);
+    if (!ifs.is_open()) { throw fs::filesystem_error("failed to open manifest", file, std::error_code(errno, std::generic_category())); }
+
+    std::string line, digest, path;
+
+    while (std::getline(ifs, line))
+    {
+        if (parseManifestLine(line, digest, path)) { addDigest(r, path, digest); }
+    }
+
+    return r;
+}
+
+bool treesha1sum::isBinaryManifest(const fs::path& file)
+{
+    char buffer[sizeof(magic)] = { 0 };
+
+    std::ifstream ifs(file, std::ios::binary);
+    ifs.read(buffer, sizeof(buffer));
+
+    return (ifs && (std::memcmp(buffer, magic, sizeof(magic)) == 0));
+}
+
+
+
+BinaryManifestWriter::BinaryManifestWriter(const fs::path& file)
+    : m_file(file), m_entries()
+{}
+
+void BinaryManifestWriter::add(const Record& record)
+{
+    Entry entry;
+    entry.path = pathStr(record.path);
+    entry.info = (uint8_t)(typeToByte(record.type) | (record.quick ? infoQuick : 0));
+    entry.size = record.size;
+    entry.mtime = record.mtime;
+    entry.symlinkTarget = ((record.type == fs::file_type::symlink) ? pathStr(record.symlinkTarget) : std::string());
+
+    const bool digestOk = ((record.type == fs::file_type::regular) && hex::decode(record.digest, entry.digest, sizeof(entry.digest)));
+    if (!digestOk) { std::memset(entry.digest, 0, sizeof(entry.digest)); }
+
+    m_entries.push_back(std::move(entry));
+}
+
+void BinaryManifestWriter::finish()
+{
+    std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) { return (a.path < b.path); });
+
+    const uint64_t count = m_entries.size();
+    const uint64_t nBlocks = (count + blockEntries - 1) / blockEntries;
+
+    std::string paths;
+    std::string index;
+    const std::string* prev = nullptr;
+
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        const Entry& entry = m_entries[i];
+        size_t shared = 0;
+
+        if ((i % blockEntries) == 0) { put64(index, paths.size()); }
+        else
+        {
+            const size_t n = std::min(prev->size(), entry.path.size());
+            while ((shared < n) && ((*prev)[shared] == entry.path[shared])) { ++shared; }
+        }
+
+        putVarint(paths, shared);
+        putVarint(paths, entry.path.size() - shared);
+        paths.append(entry.path, shared, std::string::npos);
+
+        if ((entry.info & infoTypeMask) == typeToByte(fs::file_type::symlink))
+        {
+            putVarint(paths, entry.symlinkTarget.size());
+            paths += entry.symlinkTarget;
+        }
+
+        prev = &entry.path;
+    }
+
+    const auto align = [](uint64_t offset) { return ((offset + 7) & ~(uint64_t)7); };
+
+    const uint64_t infoOffset = headerSize;
+    const uint64_t sizeOffset = align(infoOffset + count);
+    const uint64_t mtimeOffset = sizeOffset + (count * 8);
+    const uint64_t digestOffset = mtimeOffset + (count * 8);
+    const uint64_t indexOffset = align(digestOffset + (count * SHA1::digestSize));
+    const uint64_t pathOffset = indexOffset + (nBlocks * 8);
+
+    std::string data;
+    data.reserve((size_t)(pathOffset + paths.size()));
+
+    data.append(magic, sizeof(magic));
+    put32(data, formatVersion);
+    put32(data, blockEntries);
+    put64(data, count);
+    put64(data, infoOffset);
+    put64(data, sizeOffset);
+    put64(data, mtimeOffset);
+    put64(data, digestOffset);
+    put64(data, indexOffset);
+    put64(data, pathOffset);
+    put64(data, paths.size());
+
+    for (const auto& e : m_entries) { data += (char)e.info; }
+    data.resize((size_t)sizeOffset, '\0');
+
+    for (const auto& e : m_entries) { put64(data, e.size); }
+    for (const auto& e : m_entries) { put64(data, (uint64_t)e.mtime); }
+    for (const auto& e : m_entries) { data.append((const char*)e.digest, sizeof(e.digest)); }
+    data.resize((size_t)indexOffset, '\0');
+
+    data += index;
+    data += paths;
+
+    replaceFile(m_file, data);
+}
+
+
+
+BinaryManifest::BinaryManifest(const fs::path& file)
+    : m_file(std::make_unique<io::MappedFile>(file))
+{
+    const uint8_t* const data = m_file->data();
+    const uint64_t size = m_file->size();
+
+    if ((size < headerSize) || (std::memcmp(data, magic, sizeof(magic)) != 0)) { throw invalidManifest(file); }
+    if (get32(data + 8) != formatVersion) { throw std::runtime_error("unsupported binary manifest version: " + file.u8string()); }
+
+    m_blockEntries = get32(data + 12);
+    m_count = get64(data + 16);
+    m_infoOffset = get64(data + 24);
+    m_sizeOffset = get64(data + 32);
+    m_mtimeOffset = get64(data + 40);
+    m_digestOffset = get64(data + 48);
+    m_indexOffset = get64(data + 56);
+    m_pathOffset = get64(data + 64);
+    m_pathSize = get64(data + 72);
+
+    const uint64_t nBlocks = (m_blockEntries ? ((m_count / m_blockEntries) + (((m_count % m_blockEntries) != 0) ? 1 : 0)) : 0);
+
+    // `count` elements of `n` bytes at `offset` are inside the file, written so that corrupt values can't overflow
+    const auto inside = [size](uint64_t offset, uint64_t count, uint64_t n) { return ((offset <= size) && (count <= ((size - offset) / n))); };
+
+    // the sections must be inside the file, the index and the path section are checked while decoding
+    const bool ok = (m_blockEntries > 0) && inside(m_infoOffset, m_count, 1) && inside(m_sizeOffset, m_count, 8) && inside(m_mtimeOffset, m_count, 8) &&
+                    inside(m_digestOffset, m_count, SHA1::digestSize) && inside(m_indexOffset, nBlocks, 8) && inside(m_pathOffset, m_pathSize, 1);
+
+    if (!ok) { throw invalidManifest(file); }
+}
+
+bool BinaryManifest::find(const std::string& path, Record& record) const
+{
+    bool r = false;
+
+    Cursor cursor = m_lowerBound(path);
+
+    if (cursor.valid() && (cursor.path() == path))
+    {
+        // escalated files have a quick-scan record followed by the SHA1 record
+        Cursor last = cursor;
+        for (cursor.next(); cursor.valid() && (cursor.path() == path); cursor.next()) { last = cursor; }
+
+        record = m_record(last);
+        r = true;
+    }
+
+    return r;
+}
+
+void BinaryManifest::forEach(const std::string& dir, const RecordCallback& callback) const
+{
+    std::string prefix = dir;
+    if (!prefix.empty() && (prefix.back() != '/')) { prefix += '/'; }
+
+    for (Cursor cursor = m_lowerBound(prefix); cursor.valid() && (cursor.path().compare(0, prefix.size(), prefix) == 0); cursor.next())
+    {
+        callback(m_record(cursor));
+    }
+}
+
+BinaryManifest::Cursor BinaryManifest::m_lowerBound(const std::string& path) const
+{
+    const uint8_t* const data = m_file->data();
+    const uint8_t* const pathBegin = data + m_pathOffset;
+    const uint8_t* const pathEnd = pathBegin + m_pathSize;
+    const uint64_t nBlocks = (m_count + m_blockEntries - 1) / m_blockEntries;
+
+    if (nBlocks == 0) { return Cursor(pathEnd, pathEnd, data + m_infoOffset, 0, 0); }
+
+    // the index is checked here and not on open, so that a lookup only touches the pages it needs
+    const auto blockCursor = [&](uint64_t block) {
+        const uint64_t offset = get64(data + m_indexOffset + (block * 8));
+        if (offset > m_pathSize) { throw std::runtime_error("invalid binary manifest index"); }
+
+        return Cursor(pathBegin + offset, pathEnd, data + m_infoOffset, block * m_blockEntries, m_count);
+    };
+
+    // last block whose first path is not greater than `path`
+    uint64_t lo = 0, hi = nBlocks;
+
+    while ((hi - lo) > 1)
+    {
+        const uint64_t mid = lo + ((hi - lo) / 2);
+
+        if (blockCursor(mid).path() <= path) { lo = mid; }
+        else { hi = mid; }
+    }
+
+    Cursor cursor = blockCursor(lo);
+    while (cursor.valid() && (cursor.path() < path)) { cursor.next(); }
+
+    return cursor;
+}
+
+Record BinaryManifest::m_record(const Cursor& cursor) const
+{
+    const uint8_t* const data = m_file->data();
+    const uint64_t i = cursor.index();
+    const uint8_t info = data[m_infoOffset + i];
+
+    Record record;
+    record.path = fs::u8path(cursor.path());
+    record.type = fileTypes[std::min<size_t>(info & infoTypeMask, nFileTypes - 1)];
+    record.quick = ((info & infoQuick) != 0);
+
+    if (record.type == fs::file_type::regular)
+    {
+        record.size = get64(data + m_sizeOffset + (i * 8));
+        record.mtime = (int64_t)get64(data + m_mtimeOffset + (i * 8));
+        record.digest = hex::encode(data + m_digestOffset + (i * SHA1::digestSize), SHA1::digestSize);
+    }
+    else if (record.type == fs::file_type::symlink) { record.symlinkTarget = fs::u8path(cursor.symlinkTarget()); }
+
+    return record;
+}
@@ -0,0 +1,148 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+    Text manifests are the output of treesha1sum (or `sha1sum -b`): one `<digest> *<path>` line per file. Lines of
+    special files (`[symlink]  a -> b`) are skipped when reading.
+
+    Binary manifests contain the same records sorted by path, all integers are little endian:
+
+        header      "treesha1" u32 version, u32 entries per block, u64 count, u64 offsets of the sections below, u64 path size
+        info        u8 per entry, bits 0..3 file type, bit 7 quick-scan fingerprint
+        size        u64 per entry
+        mtime       i64 per entry, ns since the Unix epoch (0 if unknown, e.g. converted from text)
+        digest      20 raw bytes per entry (zeros for special files)
+        index       u64 per block, offset of the block in the path section
+        path        per entry: varint length of the prefix shared with the previous path, varint suffix length, suffix,
+                    symlinks additionally varint target length, target. The first entry of a block has no shared prefix.
+
+    Lookups binary search the first paths of the blocks and decode at most one block, through a memory mapping of the
+    file. Only the pages which are accessed are read from the disk.
+*/
+
+#ifndef IG_LIB_MANIFEST_H
+#define IG_LIB_MANIFEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "middleware/sha1.h"
+#include "reader.h"
+#include "treesha1sum.h"
+
+
+namespace treesha1sum {
+
+using DigestMap = std::unordered_map<std::string, std::string>; // path string -> digest string
+
+/**
+ * @brief Parses a `<digest> *<path>` line.
+ *
+ * @return `false` if the line is not a file entry
+ */
+bool parseManifestLine(const std::string& line, std::string& digest, std::string& path);
+
+/**
+ * @brief Parses any record line of the text manifest, including special files. Size and mtime are not available.
+ *
+ * @return `false` if the line is not a record
+ */
+bool parseManifestLine(const std::string& line, Record& record);
+
+/**
+ * @brief Formats a record as text manifest line, without line ending.
+ */
+std::string manifestLine(const Record& record);
+
+/**
+ * @brief Loads the digests of the files of a text or binary manifest.
+ */
+DigestMap loadManifest(const std::filesystem::path& file);
+
+DigestMap loadTextManifest(const std::filesystem::path& file);
+
+bool isBinaryManifest(const std::filesystem::path& file);
+
+class BinaryManifestWriter
+{
+public:
+    explicit BinaryManifestWriter(const std::filesystem::path& file);
+
+    BinaryManifestWriter(const BinaryManifestWriter& other) = delete;
+    BinaryManifestWriter& operator=(const BinaryManifestWriter& other) = delete;
+
+    void add(const Record& record);
+
+    /**
+     * @brief Sorts the records and writes the file.
+     */
+    void finish();
+
+private:
+    struct Entry
+    {
+        std::string path;
+        uint8_t info;
+        uint64_t size;
+        int64_t mtime;
+        uint8_t digest[SHA1::digestSize];
+        std::string symlinkTarget;
+    };
+
+    std::filesystem::path m_file;
+    std::vector<Entry> m_entries;
+};
+
+class BinaryManifest
+{
+public:
+    explicit BinaryManifest(const std::filesystem::path& file);
+
+    BinaryManifest(const BinaryManifest& other) = delete;
+    BinaryManifest& operator=(const BinaryManifest& other) = delete;
+
+    uint64_t count() const { return m_count; }
+
+    /**
+     * @brief Finds the last record of `path`.
+     *
+     * Escalated files have two records, the SHA1 record is written after the quick-scan record (see `Walker`), so
+     * it's the one found. `loadManifest()` prefers the quick-scan record instead, it's the baseline of the next scan.
+     */
+    bool find(const std::string& path, Record& record) const;
+
+    /**
+     * @brief Calls back the records of all entries below the directory `dir` in sorted order, all if `dir` is empty.
+     */
+    void forEach(const std::string& dir, const RecordCallback& callback) const;
+
+private:
+    class Cursor;
+
+    std::unique_ptr<io::MappedFile> m_file;
+    uint32_t m_blockEntries;
+    uint64_t m_count;
+    uint64_t m_infoOffset;
+    uint64_t m_sizeOffset;
+    uint64_t m_mtimeOffset;
+    uint64_t m_digestOffset;
+    uint64_t m_indexOffset;
+    uint64_t m_pathOffset;
+    uint64_t m_pathSize;
+
+    Cursor m_lowerBound(const std::string& path) const;
+    Record m_record(const Cursor& cursor) const;
+};
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_MANIFEST_H
@@ -0,0 +1,160 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "progress.h"
+
+
+using treesha1sum::ProgressMeter;
+
+namespace {
+
+constexpr double rateTimeConstant = 5.0; // seconds, smoothing of the displayed rate
+
+// 1234567 => 1'234'567
+std::string groupedStr(uint64_t value)
+{
+    std::string r = std::to_string(value);
+
+    for (size_t i = r.size(); i > 3; i -= 3) { r.insert(i - 3, 1, '\''); }
+
+    return r;
+}
+
+std::string sizeStr(uint64_t bytes, uint64_t unit)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << ((double)bytes / (double)unit);
+    return oss.str();
+}
+
+std::string durationStr(uint64_t seconds)
+{
+    std::ostringstream oss;
+    oss << (seconds / 3600) << ':' << std::setfill('0') << std::setw(2) << ((seconds / 60) % 60) << ':' << std::setw(2) << (seconds % 60);
+    return oss.str();
+}
+
+} // namespace
+
+
+
+ProgressMeter::ProgressMeter(const Progress& progress, std::ostream& os, Style style, std::chrono::milliseconds interval)
+    : m_progress(progress),
+      m_os(os),
+      m_style(style),
+      m_interval(interval),
+      m_mtx(),
+      m_cv(),
+      m_stop(false),
+      m_thread(),
+      m_lastTime(std::chrono::steady_clock::now()),
+      m_lastBytes(progress.bytesDone.load()),
+      m_rate(-1),
+      m_lineWidth(0)
+{
+    m_thread = std::thread(&ProgressMeter::m_worker, this);
+}
+
+ProgressMeter::~ProgressMeter() { stop(); }
+
+void ProgressMeter::stop()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lg(m_mtx);
+            m_stop = true;
+        }
+
+        m_cv.notify_all();
+        m_thread.join();
+
+        m_render(true);
+    }
+}
+
+void ProgressMeter::m_worker()
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+
+    while (!m_cv.wait_for(lock, m_interval, [this] { return m_stop; })) { m_render(false); }
+}
+
+void ProgressMeter::m_render(bool final)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t filesDone = m_progress.filesDone.load(std::memory_order_relaxed);
+    const uint64_t bytesDone = m_progress.bytesDone.load(std::memory_order_relaxed);
+    const bool totalKnown = m_progress.totalKnown.load();
+    const uint64_t filesTotal = std::max(m_progress.filesTotal.load(), filesDone);
+    const uint64_t bytesTotal = std::max(m_progress.bytesTotal.load(), bytesDone);
+
+    const double dt = std::chrono::duration<double>(now - m_lastTime).count();
+
+    if (dt > 0)
+    {
+        const double rate = (double)(bytesDone - m_lastBytes) / dt;
+
+        if (m_rate < 0) { m_rate = rate; }
+        else { m_rate += (rate - m_rate) * (1.0 - std::exp(-dt / rateTimeConstant)); }
+
+        m_lastTime = now;
+        m_lastBytes = bytesDone;
+    }
+
+    const bool etaKnown = (totalKnown && (m_rate > 0));
+    const uint64_t eta = (etaKnown ? (uint64_t)std::ceil((double)(bytesTotal - bytesDone) / m_rate) : 0);
+
+    std::ostringstream line;
+
+    if (m_style == Style::statusLine)
+    {
+        const uint64_t unit = (bytesTotal >= (1024llu * 1024 * 1024) ? (1024llu * 1024 * 1024) : (1024 * 1024));
+        const char* const more = (totalKnown ? "" : "+");
+
+        line << groupedStr(filesDone) << '/' << groupedStr(filesTotal) << more << " files  ";
+        line << sizeStr(bytesDone, unit) << '/' << sizeStr(bytesTotal, unit) << more << (unit == (1024 * 1024) ? " MiB  " : " GiB  ");
+        line << std::fixed << std::setprecision(1) << (std::max(m_rate, 0.0) / 1e6) << " MB/s  ";
+        line << "ETA " << (etaKnown ? durationStr(eta) : "?");
+
+        // overwrite the rest of the previous line, no ANSI escape sequences as they may be disabled
+        std::string str = line.str();
+        const size_t width = str.size();
+        if (width < m_lineWidth) { str.append(m_lineWidth - width, ' '); }
+        m_lineWidth = width;
+
+        m_os << '\r' << str;
+        if (final) { m_os << '\n'; }
+    }
+    else
+    {
+        line << "progress files=" << filesDone << '/';
+        if (totalKnown) { line << filesTotal; }
+        else { line << '-'; }
+
+        line << " bytes=" << bytesDone << '/';
+        if (totalKnown) { line << bytesTotal; }
+        else { line << '-'; }
+
+        line << " rate=" << (uint64_t)std::max(m_rate, 0.0) << " eta=";
+        if (etaKnown) { line << eta; }
+        else { line << '-'; }
+
+        m_os << line.str() << '\n';
+    }
+
+    m_os << std::flush;
+}
@@ -0,0 +1,104 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#ifndef IG_LIB_PROGRESS_H
+#define IG_LIB_PROGRESS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+
+namespace treesha1sum {
+
+/**
+ * @brief Progress counters of a walk, written by the hashing threads and the pre-scan, read by `ProgressMeter`.
+ *
+ * The counters are lock-free, the writers add in batches. Only regular files are counted. Bytes of files which are
+ * not read (checkpoint, quick-scan) are counted as done too, so that `bytesDone` converges to `bytesTotal`.
+ */
+struct Progress
+{
+    std::atomic<uint64_t> filesDone{ 0 };
+    std::atomic<uint64_t> bytesDone{ 0 };
+
+    // set by the metadata pre-scan of `Walker::walk()`, lower bounds until `totalKnown` is set
+    std::atomic<uint64_t> filesTotal{ 0 };
+    std::atomic<uint64_t> bytesTotal{ 0 };
+    std::atomic<bool> totalKnown{ false };
+
+    void addBytes(uint64_t count) { bytesDone.fetch_add(count, std::memory_order_relaxed); }
+
+    void fileDone(uint64_t remainingBytes)
+    {
+        if (remainingBytes > 0) { addBytes(remainingBytes); }
+        filesDone.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Periodically renders a `Progress` on a background thread.
+ *
+ * `Style::statusLine` overwrites a single line (`\r`), intended for a terminal:
+ *
+ *     1'234/5'678 files  1.2/3.4 GiB  123.4 MB/s  ETA 0:01:23
+ *
+ * `Style::log` writes one line per interval, intended for log files and other programs. Unknown values are `-`:
+ *
+ *     progress files=1234/5678 bytes=1288490188/3650722201 rate=123400000 eta=83
+ *
+ * Totals of a running pre-scan are marked with a `+` in the status line and are `-` in the log.
+ */
+class ProgressMeter
+{
+public:
+    enum class Style
+    {
+        statusLine,
+        log,
+    };
+
+public:
+    ProgressMeter(const Progress& progress, std::ostream& os, Style style, std::chrono::milliseconds interval);
+    ~ProgressMeter();
+
+    ProgressMeter(const ProgressMeter& other) = delete;
+    ProgressMeter& operator=(const ProgressMeter& other) = delete;
+
+    /**
+     * @brief Renders the final state and stops the thread. Called by the destructor if not called explicitly.
+     */
+    void stop();
+
+private:
+    const Progress& m_progress;
+    std::ostream& m_os;
+    Style m_style;
+    std::chrono::milliseconds m_interval;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    bool m_stop;
+    std::thread m_thread;
+
+    std::chrono::steady_clock::time_point m_lastTime;
+    uint64_t m_lastBytes;
+    double m_rate; // bytes per second, exponential moving average
+    size_t m_lineWidth;
+
+    void m_worker();
+    void m_render(bool final);
+};
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_PROGRESS_H
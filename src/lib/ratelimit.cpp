@@ -0,0 +1,133 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "ratelimit.h"
+
+#include <omw/defs.h>
+
+#ifdef OMW_PLAT_WIN
+#ifndef NOMINMAX
+#define NOMINMAX // std::min() and std::max() are used
+#endif
+#include <Windows.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __APPLE__
+#include <sys/resource.h>
+#endif
+
+
+using treesha1sum::RateLimiter;
+using treesha1sum::TokenBucket;
+
+namespace {
+
+// the buckets hold at most the tokens of this time, so that an idle phase isn't followed by a burst
+constexpr double burstTime = 0.05; // seconds
+
+#ifdef __linux__
+// <linux/ioprio.h> is missing on older systems
+constexpr int ioprioWhoProcess = 1;
+constexpr int ioprioClassIdle = 3;
+constexpr int ioprioClassShift = 13;
+#endif
+
+} // namespace
+
+
+
+TokenBucket::TokenBucket(double rate, double burst)
+    : m_rate(rate), m_burst(burst), m_mtx(), m_tokens(burst), m_last(std::chrono::steady_clock::now())
+{}
+
+std::chrono::nanoseconds TokenBucket::take(double amount)
+{
+    std::lock_guard<std::mutex> lg(m_mtx);
+
+    const auto now = std::chrono::steady_clock::now();
+    const double dt = std::chrono::duration<double>(now - m_last).count();
+    m_last = now;
+
+    m_tokens = std::min(m_burst, m_tokens + (dt * m_rate)) - amount;
+
+    return ((m_tokens < 0) ? std::chrono::nanoseconds((int64_t)((-m_tokens / m_rate) * 1e9)) : std::chrono::nanoseconds(0));
+}
+
+RateLimiter::RateLimiter(uint64_t bytesPerSecond, uint64_t opsPerSecond, double cpuCores)
+    : m_bytes(), m_ops(), m_cpu(), m_start(std::chrono::steady_clock::now()), m_bytesRead(0), m_opsDone(0), m_cpuNs(0), m_throttledNs(0)
+{
+    if (bytesPerSecond > 0) { m_bytes = std::make_unique<TokenBucket>((double)bytesPerSecond, (double)bytesPerSecond * burstTime); }
+    if (opsPerSecond > 0) { m_ops = std::make_unique<TokenBucket>((double)opsPerSecond, std::max((double)opsPerSecond * burstTime, 1.0)); }
+    if (cpuCores > 0) { m_cpu = std::make_unique<TokenBucket>(cpuCores, cpuCores * burstTime); }
+}
+
+void RateLimiter::read(uint64_t count)
+{
+    m_bytesRead.fetch_add(count, std::memory_order_relaxed);
+    m_opsDone.fetch_add(1, std::memory_order_relaxed);
+
+    // both buckets refill while sleeping, so the longer wait covers both
+    std::chrono::nanoseconds wait(0);
+    if (m_bytes) { wait = std::max(wait, m_bytes->take((double)count)); }
+    if (m_ops) { wait = std::max(wait, m_ops->take(1)); }
+
+    m_wait(wait);
+}
+
+void RateLimiter::cpu(std::chrono::nanoseconds duration)
+{
+    m_cpuNs.fetch_add(duration.count(), std::memory_order_relaxed);
+
+    if (m_cpu) { m_wait(m_cpu->take(std::chrono::duration<double>(duration).count())); }
+}
+
+RateLimiter::Stats RateLimiter::stats() const
+{
+    Stats r;
+
+    r.bytes = m_bytesRead.load(std::memory_order_relaxed);
+    r.ops = m_opsDone.load(std::memory_order_relaxed);
+    r.cpu = std::chrono::nanoseconds(m_cpuNs.load(std::memory_order_relaxed));
+    r.throttled = std::chrono::nanoseconds(m_throttledNs.load(std::memory_order_relaxed));
+    r.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+
+    return r;
+}
+
+void RateLimiter::m_wait(std::chrono::nanoseconds duration)
+{
+    if (duration.count() > 0)
+    {
+        std::this_thread::sleep_for(duration);
+        m_throttledNs.fetch_add(duration.count(), std::memory_order_relaxed);
+    }
+}
+
+bool treesha1sum::setIdleIoPriority()
+{
+#if defined(OMW_PLAT_WIN)
+    return (::SetPriorityClass(::GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN) != 0);
+#elif defined(__linux__)
+    return (::syscall(SYS_ioprio_set, ioprioWhoProcess, 0, ioprioClassIdle << ioprioClassShift) == 0);
+#elif defined(__APPLE__)
+    return (::setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_PROCESS, IOPOL_THROTTLE) == 0);
+#else
+    return false;
+#endif
+}
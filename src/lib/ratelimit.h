@@ -0,0 +1,114 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#ifndef IG_LIB_RATELIMIT_H
+#define IG_LIB_RATELIMIT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+namespace treesha1sum {
+
+/**
+ * @brief Thread-safe token bucket, filled with `rate` tokens per second up to `burst` tokens.
+ *
+ * Tokens are taken after the work has been done, the balance may become negative. Each caller then waits until its
+ * debt is paid off, so concurrent callers are paced one after the other instead of all stalling at once.
+ */
+class TokenBucket
+{
+public:
+    TokenBucket(double rate, double burst);
+
+    /**
+     * @brief Takes `amount` tokens.
+     *
+     * @return Time to wait until the balance isn't negative anymore
+     */
+    std::chrono::nanoseconds take(double amount);
+
+private:
+    double m_rate;
+    double m_burst;
+    std::mutex m_mtx;
+    double m_tokens;
+    std::chrono::steady_clock::time_point m_last;
+};
+
+/**
+ * @brief Limits the read throughput, the read operations per second and the CPU time used for hashing.
+ *
+ * A single instance is shared by all hashing threads of a walk (`Options::rateLimiter`). The readers report every
+ * read and the hashing time to it and are put to sleep as long as any of the limits is exceeded.
+ */
+class RateLimiter
+{
+public:
+    struct Stats
+    {
+        uint64_t bytes;
+        uint64_t ops;
+        std::chrono::nanoseconds cpu;       // time spent hashing, summed over all threads
+        std::chrono::nanoseconds throttled; // time slept, summed over all threads
+        std::chrono::nanoseconds elapsed;   // since construction
+    };
+
+public:
+    /**
+     * @param bytesPerSecond Max read throughput, 0 = unlimited
+     * @param opsPerSecond Max number of read operations per second, 0 = unlimited
+     * @param cpuCores Max CPU time per second used for hashing, e.g. 0.5 = half a core, 0 = unlimited
+     */
+    RateLimiter(uint64_t bytesPerSecond, uint64_t opsPerSecond, double cpuCores);
+
+    RateLimiter(const RateLimiter& other) = delete;
+    RateLimiter& operator=(const RateLimiter& other) = delete;
+
+    /**
+     * @brief Called after a read operation of `count` bytes, blocks if the byte or operation rate is exceeded.
+     */
+    void read(uint64_t count);
+
+    /**
+     * @brief Called after hashing, blocks if the CPU budget is exceeded.
+     */
+    void cpu(std::chrono::nanoseconds duration);
+
+    Stats stats() const;
+
+private:
+    std::unique_ptr<TokenBucket> m_bytes; // nullptr if unlimited
+    std::unique_ptr<TokenBucket> m_ops;
+    std::unique_ptr<TokenBucket> m_cpu; // tokens are seconds
+    std::chrono::steady_clock::time_point m_start;
+
+    std::atomic<uint64_t> m_bytesRead;
+    std::atomic<uint64_t> m_opsDone;
+    std::atomic<int64_t> m_cpuNs;
+    std::atomic<int64_t> m_throttledNs;
+
+    void m_wait(std::chrono::nanoseconds duration);
+};
+
+/**
+ * @brief Sets the I/O priority of the process to idle, so that it only gets disk time when no one else needs it.
+ *
+ * Linux: `ioprio_set(IOPRIO_CLASS_IDLE)`, only effective with the BFQ and CFQ schedulers. Windows: background
+ * processing mode (also lowers the memory priority). macOS: `IOPOL_THROTTLE`. Has to be called before the hashing
+ * threads are created, they inherit it.
+ *
+ * @return `false` if not supported or failed
+ */
+bool setIdleIoPriority();
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_RATELIMIT_H
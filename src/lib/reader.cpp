@@ -0,0 +1,291 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include "ratelimit.h"
+#include "reader.h"
+
+#include <omw/defs.h>
+
+#ifdef OMW_PLAT_WIN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+
+namespace fs = std::filesystem;
+
+namespace {
+
+fs::filesystem_error error(const char* what, const fs::path& path, int errnum)
+{
+    return fs::filesystem_error(what, path, std::error_code(errnum, std::generic_category()));
+}
+
+#ifdef OMW_PLAT_WIN
+fs::filesystem_error winError(const char* what, const fs::path& path, DWORD err)
+{
+    return fs::filesystem_error(what, path, std::error_code((int)err, std::system_category()));
+}
+#endif
+
+#ifndef OMW_PLAT_WIN
+
+class FileDescriptor
+{
+public:
+    explicit FileDescriptor(const fs::path& path)
+        : m_fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+    {
+        if (m_fd < 0) { throw error("failed to open file", path, errno); }
+    }
+
+    ~FileDescriptor() { ::close(m_fd); }
+
+    FileDescriptor(const FileDescriptor& other) = delete;
+    FileDescriptor& operator=(const FileDescriptor& other) = delete;
+
+    int get() const { return m_fd; }
+
+private:
+    int m_fd;
+};
+
+#endif
+
+#if !defined(OMW_PLAT_WIN) && defined(SEEK_DATA) && defined(SEEK_HOLE)
+
+// holes are fed from this, so that they don't need any buffer to be cleared
+const uint8_t zeroPage[64 * 1024] = { 0 };
+
+void feedZeros(uint64_t count, const treesha1sum::io::DataSink& sink)
+{
+    while (count > 0)
+    {
+        const size_t n = (size_t)std::min<uint64_t>(count, sizeof(zeroPage));
+        sink(zeroPage, n);
+        count -= n;
+    }
+}
+
+#endif
+
+} // namespace
+
+
+
+uint64_t treesha1sum::io::readBlock(const fs::path& path, std::vector<uint8_t>& buffer, const DataSink& sink, uint64_t offset, RateLimiter* limiter)
+{
+    uint64_t total = 0;
+    std::ifstream fstream(path, std::ios::binary);
+
+    if (!fstream.is_open()) { throw error("failed to open file", path, errno); }
+
+    if ((offset > 0) && !fstream.seekg((std::streamoff)offset)) { throw error("failed to seek", path, EINVAL); }
+
+    if (buffer.empty()) { buffer.resize(1); }
+
+    while (fstream)
+    {
+        fstream.read((char*)buffer.data(), (std::streamsize)buffer.size());
+
+        const size_t count = (size_t)fstream.gcount();
+
+        if (count > 0)
+        {
+            if (limiter) { limiter->read(count); }
+            sink(buffer.data(), count);
+        }
+
+        total += count;
+    }
+
+    return total;
+}
+
+uint64_t treesha1sum::io::readSparse(const fs::path& path, std::vector<uint8_t>& buffer, const DataSink& sink, uint64_t offset, RateLimiter* limiter)
+{
+#if !defined(OMW_PLAT_WIN) && defined(SEEK_DATA) && defined(SEEK_HOLE)
+
+    const FileDescriptor fd(path);
+    struct stat st;
+
+    if (::fstat(fd.get(), &st) != 0) { throw error("failed to stat file", path, errno); }
+
+    // only regular files have extents, everything else is read sequentially
+    if (!S_ISREG(st.st_mode)) { return readBlock(path, buffer, sink, offset, limiter); }
+
+    if (buffer.empty()) { buffer.resize(1); }
+
+    const uint64_t size = (uint64_t)st.st_size;
+    uint64_t pos = offset;
+
+    while (pos < size)
+    {
+        uint64_t dataBegin;
+        uint64_t dataEnd;
+
+        const off_t data = ::lseek(fd.get(), (off_t)pos, SEEK_DATA);
+
+        if (data >= 0)
+        {
+            dataBegin = std::min<uint64_t>((uint64_t)data, size);
+
+            const off_t hole = ::lseek(fd.get(), data, SEEK_HOLE);
+            dataEnd = ((hole >= 0) ? std::min<uint64_t>((uint64_t)hole, size) : size);
+        }
+        else if (errno == ENXIO) // no more data after pos, the rest of the file is a hole
+        {
+            dataBegin = size;
+            dataEnd = size;
+        }
+        else if (errno == EINVAL) // hole detection not supported by the filesystem
+        {
+            dataBegin = pos;
+            dataEnd = size;
+        }
+        else { throw error("failed to seek data", path, errno); }
+
+        feedZeros(dataBegin - pos, sink);
+        pos = dataBegin;
+
+        while (pos < dataEnd)
+        {
+            const size_t count = (size_t)std::min<uint64_t>(dataEnd - pos, buffer.size());
+            const ssize_t res = ::pread(fd.get(), buffer.data(), count, (off_t)pos);
+
+            if (res < 0)
+            {
+                if (errno == EINTR) { continue; }
+                throw error("failed to read file", path, errno);
+            }
+            else if (res == 0) { return (pos - offset); } // the file has been truncated while reading
+
+            if (limiter) { limiter->read((uint64_t)res); }
+            sink(buffer.data(), (size_t)res);
+            pos += (uint64_t)res;
+        }
+    }
+
+    return ((pos > offset) ? (pos - offset) : 0);
+
+#else  // hole detection not available
+    return readBlock(path, buffer, sink, offset, limiter);
+#endif
+}
+
+uint64_t treesha1sum::io::diskLocation(const fs::path& path)
+{
+    uint64_t r = 0;
+
+#ifdef __linux__
+    try
+    {
+        const FileDescriptor fd(path);
+
+        alignas(struct fiemap) uint8_t buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = { 0 };
+        struct fiemap* const fm = (struct fiemap*)buffer;
+        fm->fm_start = 0;
+        fm->fm_length = FIEMAP_MAX_OFFSET;
+        fm->fm_extent_count = 1;
+
+        struct stat st;
+
+        if ((::ioctl(fd.get(), FS_IOC_FIEMAP, fm) == 0) && (fm->fm_mapped_extents > 0)) { r = fm->fm_extents[0].fe_physical; }
+        else if (::fstat(fd.get(), &st) == 0) { r = (uint64_t)st.st_ino; }
+    }
+    catch (...)
+    {
+        // the error is reported when the file is hashed
+    }
+#else
+    (void)path;
+#endif
+
+    return r;
+}
+
+treesha1sum::io::MappedFile::MappedFile(const fs::path& path)
+    : m_data(nullptr), m_size(0), m_mapping(nullptr)
+{
+#ifdef OMW_PLAT_WIN
+    const HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { throw winError("failed to open file", path, ::GetLastError()); }
+
+    LARGE_INTEGER size;
+
+    if (!::GetFileSizeEx(file, &size))
+    {
+        const DWORD err = ::GetLastError();
+        ::CloseHandle(file);
+        throw winError("failed to get file size", path, err);
+    }
+
+    m_size = (size_t)size.QuadPart;
+
+    if (m_size > 0)
+    {
+        m_mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const DWORD mappingErr = ::GetLastError();
+        ::CloseHandle(file); // the mapping keeps the file open
+
+        if (!m_mapping) { throw winError("failed to map file", path, mappingErr); }
+
+        m_data = (const uint8_t*)::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (!m_data)
+        {
+            const DWORD err = ::GetLastError();
+            ::CloseHandle(m_mapping);
+            throw winError("failed to map file", path, err);
+        }
+    }
+    else { ::CloseHandle(file); }
+#else
+    const FileDescriptor fd(path);
+    struct stat st;
+
+    if (::fstat(fd.get(), &st) != 0) { throw error("failed to stat file", path, errno); }
+
+    m_size = (size_t)st.st_size;
+
+    if (m_size > 0)
+    {
+        void* const p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd.get(), 0); // the mapping stays valid after close
+        if (p == MAP_FAILED) { throw error("failed to map file", path, errno); }
+
+        m_data = (const uint8_t*)p;
+    }
+#endif
+}
+
+treesha1sum::io::MappedFile::~MappedFile()
+{
+#ifdef OMW_PLAT_WIN
+    if (m_data) { ::UnmapViewOfFile(m_data); }
+    if (m_mapping) { ::CloseHandle(m_mapping); }
+#else
+    if (m_data) { ::munmap((void*)m_data, m_size); }
+#endif
+}
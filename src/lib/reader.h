@@ -0,0 +1,77 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#ifndef IG_LIB_READER_H
+#define IG_LIB_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+
+namespace treesha1sum {
+
+class RateLimiter;
+
+namespace io {
+
+    using DataSink = std::function<void(const uint8_t* data, size_t count)>;
+
+    /**
+     * @brief Reads the file from `offset` to the end in chunks of `buffer.size()` and passes them to the sink.
+     *
+     * @param limiter Every read is reported to it if not null
+     * @return Number of bytes passed to the sink
+     */
+    uint64_t readBlock(const std::filesystem::path& path, std::vector<uint8_t>& buffer, const DataSink& sink, uint64_t offset = 0,
+                       RateLimiter* limiter = nullptr);
+
+    /**
+     * @brief Like `readBlock()`, but only reads the allocated extents of sparse files.
+     *
+     * The extents are found with `lseek(SEEK_DATA/SEEK_HOLE)`, holes are passed to the sink as zeros without
+     * touching the disk. The data seen by the sink is identical to `readBlock()`. Falls back to `readBlock()` on
+     * platforms or filesystems without hole detection. Holes are not reported to the limiter.
+     */
+    uint64_t readSparse(const std::filesystem::path& path, std::vector<uint8_t>& buffer, const DataSink& sink, uint64_t offset = 0,
+                        RateLimiter* limiter = nullptr);
+
+    /**
+     * @brief Sort key for reading files in the order they are stored on the disk.
+     *
+     * On Linux this is the physical offset of the first extent (`FIEMAP`), or the inode number if the filesystem
+     * doesn't support `FIEMAP`. On other platforms and on error 0 is returned.
+     */
+    uint64_t diskLocation(const std::filesystem::path& path);
+
+    /**
+     * @brief Read-only memory mapping of a whole file, the pages are only read from the disk when they are accessed.
+     */
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::filesystem::path& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        const uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        const uint8_t* m_data; // nullptr if the file is empty
+        size_t m_size;
+        void* m_mapping; // handle of the file mapping object, only used on Windows
+    };
+
+} // namespace io
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_READER_H
@@ -0,0 +1,412 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gitindex.h"
+#include "middleware/sha1.h"
+#include "progress.h"
+#include "ratelimit.h"
+#include "tar.h"
+#include "treesha1sum.h"
+
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t blockSize = 512;
+
+// ustar header field offsets and sizes
+constexpr size_t nameOffs = 0, nameSize = 100;
+constexpr size_t sizeOffs = 124, sizeSize = 12;
+constexpr size_t mtimeOffs = 136, mtimeSize = 12;
+constexpr size_t chksumOffs = 148, chksumSize = 8;
+constexpr size_t typeOffs = 156;
+constexpr size_t linkOffs = 157, linkSize = 100;
+constexpr size_t magicOffs = 257;
+constexpr size_t prefixOffs = 345, prefixSize = 155;
+
+class TarReader
+{
+public:
+    explicit TarReader(std::istream& is)
+        : m_is(is)
+    {}
+
+    // returns false at the end of the input
+    bool readHeader(uint8_t* block)
+    {
+        m_is.read((char*)block, blockSize);
+
+        const size_t count = (size_t)m_is.gcount();
+
+        if ((count != 0) && (count != blockSize)) { throw std::runtime_error("unexpected end of tar archive"); }
+
+        return (count == blockSize);
+    }
+
+    void read(uint8_t* data, size_t count)
+    {
+        m_is.read((char*)data, (std::streamsize)count);
+
+        if ((size_t)m_is.gcount() != count) { throw std::runtime_error("unexpected end of tar archive"); }
+    }
+
+    std::string readString(uint64_t size)
+    {
+        if (size > (16 * 1024 * 1024)) { throw std::runtime_error("tar extended header too large"); }
+
+        std::string r((size_t)size, '\0');
+        read((uint8_t*)r.data(), r.size());
+        skipPadding(size);
+
+        return r;
+    }
+
+    void skip(uint64_t count, std::vector<uint8_t>& buffer)
+    {
+        while (count > 0)
+        {
+            const size_t n = (size_t)std::min<uint64_t>(count, buffer.size());
+            read(buffer.data(), n);
+            count -= n;
+        }
+    }
+
+    void skipPadding(uint64_t size)
+    {
+        uint8_t tmp[blockSize];
+        const size_t rem = (size_t)(size % blockSize);
+
+        if (rem != 0) { read(tmp, blockSize - rem); }
+    }
+
+private:
+    std::istream& m_is;
+};
+
+std::string field(const uint8_t* block, size_t offs, size_t size)
+{
+    const char* const p = (const char*)(block + offs);
+    return std::string(p, std::find(p, p + size, '\0'));
+}
+
+uint64_t numField(const uint8_t* block, size_t offs, size_t size)
+{
+    uint64_t r = 0;
+    const uint8_t* const p = block + offs;
+
+    if (p[0] & 0x80) // GNU base-256
+    {
+        r = p[0] & 0x7F;
+        for (size_t i = 1; i < size; ++i) { r = (r << 8) | p[i]; }
+    }
+    else
+    {
+        size_t i = 0;
+        while ((i < size) && (p[i] == ' ')) { ++i; }
+
+        for (; (i < size) && (p[i] >= '0') && (p[i] <= '7'); ++i) { r = (r << 3) | (uint64_t)(p[i] - '0'); }
+    }
+
+    return r;
+}
+
+bool isZeroBlock(const uint8_t* block) { return std::all_of(block, block + blockSize, [](uint8_t b) { return (b == 0); }); }
+
+bool checksumOk(const uint8_t* block)
+{
+    const uint64_t expected = numField(block, chksumOffs, chksumSize);
+    uint64_t sum = 0;
+    int64_t signedSum = 0; // some old tar implementations used signed chars
+
+    for (size_t i = 0; i < blockSize; ++i)
+    {
+        const uint8_t b = (((i >= chksumOffs) && (i < (chksumOffs + chksumSize))) ? ' ' : block[i]);
+        sum += b;
+        signedSum += (int8_t)b;
+    }
+
+    return ((sum == expected) || ((uint64_t)signedSum == expected));
+}
+
+struct PaxOverrides
+{
+    bool hasPath = false;
+    bool hasLinkPath = false;
+    bool hasSize = false;
+    bool hasMtime = false;
+    std::string path;
+    std::string linkPath;
+    uint64_t size = 0;
+    int64_t mtime = 0; // ns
+};
+
+// records are "<length> <key>=<value>\n"
+void parsePax(const std::string& data, PaxOverrides& pax)
+{
+    size_t pos = 0;
+
+    while (pos < data.size())
+    {
+        const size_t sp = data.find(' ', pos);
+        if (sp == std::string::npos) { break; }
+
+        const size_t len = (size_t)std::strtoull(data.c_str() + pos, nullptr, 10);
+        if ((len == 0) || ((pos + len) > data.size())) { throw std::runtime_error("malformed pax extended header"); }
+
+        const std::string record = data.substr(sp + 1, pos + len - sp - 2); // without the trailing newline
+        const size_t eq = record.find('=');
+
+        if (eq != std::string::npos)
+        {
+            const std::string key = record.substr(0, eq);
+            const std::string value = record.substr(eq + 1);
+
+            if (key == "path")
+            {
+                pax.path = value;
+                pax.hasPath = true;
+            }
+            else if (key == "linkpath")
+            {
+                pax.linkPath = value;
+                pax.hasLinkPath = true;
+            }
+            else if (key == "size")
+            {
+                pax.size = std::strtoull(value.c_str(), nullptr, 10);
+                pax.hasSize = true;
+            }
+            else if (key == "mtime") // seconds with optional fraction
+            {
+                char* end = nullptr;
+                pax.mtime = (int64_t)std::strtoll(value.c_str(), &end, 10) * 1000000000;
+
+                if (end && (*end == '.'))
+                {
+                    int64_t ns = 0;
+                    int digits = 0;
+
+                    for (++end; (*end >= '0') && (*end <= '9') && (digits < 9); ++end, ++digits) { ns = (ns * 10) + (*end - '0'); }
+                    for (; digits < 9; ++digits) { ns *= 10; }
+
+                    pax.mtime += ((value[0] == '-') ? -ns : ns);
+                }
+
+                pax.hasMtime = true;
+            }
+            else if (key.compare(0, 10, "GNU.sparse") == 0) { throw std::runtime_error("sparse tar members are not supported"); }
+        }
+
+        pos += len;
+    }
+}
+
+bool isExcluded(const std::vector<std::string>& excludeNames, const fs::path& path)
+{
+    bool r = false;
+
+    for (const auto& e : path)
+    {
+        if (std::find(excludeNames.begin(), excludeNames.end(), e.u8string()) != excludeNames.end())
+        {
+            r = true;
+            break;
+        }
+    }
+
+    return r;
+}
+
+} // namespace
+
+
+
+void treesha1sum::hashTar(std::istream& is, const Options& options, const RecordCallback& callback)
+{
+    TarReader tar(is);
+    uint8_t header[blockSize];
+    std::vector<uint8_t> buffer(std::max<size_t>(options.readBufferSize, blockSize));
+    std::unordered_map<std::string, std::pair<std::string, uint64_t>> regularMembers; // path -> digest, size; for hard links
+
+    PaxOverrides pax;
+    std::string gnuLongName;
+    std::string gnuLongLink;
+
+    while (tar.readHeader(header))
+    {
+        if (isZeroBlock(header)) { break; } // end of archive
+        if (!checksumOk(header)) { throw std::runtime_error("invalid tar header checksum"); }
+
+        const char type = (char)header[typeOffs];
+        uint64_t size = numField(header, sizeOffs, sizeSize);
+
+        // extension headers apply to the next member
+        if (type == 'x')
+        {
+            parsePax(tar.readString(size), pax);
+            continue;
+        }
+        else if (type == 'g')
+        {
+            tar.skip(size, buffer);
+            tar.skipPadding(size);
+            continue;
+        }
+        else if ((type == 'L') || (type == 'K'))
+        {
+            std::string str = tar.readString(size);
+            str.erase(std::find(str.begin(), str.end(), '\0'), str.end());
+
+            if (type == 'L') { gnuLongName = str; }
+            else { gnuLongLink = str; }
+
+            continue;
+        }
+        else if (type == 'S') { throw std::runtime_error("sparse tar members are not supported"); }
+        else if (type == 'M') { throw std::runtime_error("multi-volume tar archives are not supported"); }
+
+        std::string name;
+        std::string linkName;
+
+        if (pax.hasPath) { name = pax.path; }
+        else if (!gnuLongName.empty()) { name = gnuLongName; }
+        else
+        {
+            name = field(header, nameOffs, nameSize);
+
+            // the prefix field is only used by ustar, GNU stores other data there
+            const std::string prefix = field(header, prefixOffs, prefixSize);
+            if ((field(header, magicOffs, 6) == "ustar") && !prefix.empty()) { name = prefix + "/" + name; }
+        }
+
+        if (pax.hasLinkPath) { linkName = pax.linkPath; }
+        else if (!gnuLongLink.empty()) { linkName = gnuLongLink; }
+        else { linkName = field(header, linkOffs, linkSize); }
+
+        if (pax.hasSize) { size = pax.size; }
+
+        const int64_t mtime = (pax.hasMtime ? pax.mtime : ((int64_t)numField(header, mtimeOffs, mtimeSize) * 1000000000));
+
+        pax = PaxOverrides();
+        gnuLongName.clear();
+        gnuLongLink.clear();
+
+        // link, device, directory and fifo members have no data
+        const bool hasData = ((type != '1') && (type != '2') && (type != '3') && (type != '4') && (type != '5') && (type != '6'));
+        const fs::path path = fs::u8path(name);
+
+        Record rec;
+        rec.path = path;
+
+        if (!hasData) { size = 0; }
+
+        if (isExcluded(options.excludeNames, path))
+        {
+            tar.skip(size, buffer);
+            tar.skipPadding(size);
+            continue;
+        }
+
+        switch (type)
+        {
+        case '1':
+        {
+            const auto it = regularMembers.find(fs::u8path(linkName).lexically_normal().u8string());
+            if (it == regularMembers.end()) { throw std::runtime_error("hard link target not found in tar archive: " + linkName); }
+
+            rec.type = fs::file_type::regular;
+            rec.digest = it->second.first;
+            rec.size = it->second.second;
+            rec.mtime = mtime;
+            break;
+        }
+
+        case '2':
+            rec.type = fs::file_type::symlink;
+            rec.symlinkTarget = fs::u8path(linkName);
+            break;
+
+        case '3':
+            rec.type = fs::file_type::character;
+            break;
+
+        case '4':
+            rec.type = fs::file_type::block;
+            break;
+
+        case '5':
+            rec.type = fs::file_type::directory;
+            break;
+
+        case '6':
+            rec.type = fs::file_type::fifo;
+            break;
+
+        case '0':
+        case '\0': // pre-POSIX regular file
+        case '7':  // contiguous file
+        {
+            SHA1 sha1;
+            uint64_t remaining = size;
+
+            if (options.gitBlob) { sha1.update(gitBlobHeader(size)); }
+
+            while (remaining > 0)
+            {
+                const size_t n = (size_t)std::min<uint64_t>(remaining, buffer.size());
+                tar.read(buffer.data(), n);
+
+                if (options.rateLimiter)
+                {
+                    options.rateLimiter->read(n);
+
+                    const auto t0 = std::chrono::steady_clock::now();
+                    sha1.update(buffer.data(), n);
+                    options.rateLimiter->cpu(std::chrono::steady_clock::now() - t0);
+                }
+                else { sha1.update(buffer.data(), n); }
+
+                remaining -= n;
+
+                if (options.progress) { options.progress->addBytes(n); }
+            }
+
+            tar.skipPadding(size);
+
+            if (options.progress) { options.progress->fileDone(0); }
+
+            rec.type = fs::file_type::regular;
+            rec.size = size;
+            rec.mtime = mtime;
+            rec.digest = sha1.digest();
+
+            regularMembers[path.lexically_normal().u8string()] = { rec.digest, rec.size };
+            break;
+        }
+
+        default: // GNU volume labels ('V') and dumpdirs ('D'), and unknown types
+            tar.skip(size, buffer);
+            tar.skipPadding(size);
+            continue;
+        }
+
+        if (rec.type != fs::file_type::directory) { callback(rec); }
+    }
+}
@@ -0,0 +1,36 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#ifndef IG_LIB_TAR_H
+#define IG_LIB_TAR_H
+
+#include <istream>
+
+#include "treesha1sum.h"
+
+
+namespace treesha1sum {
+
+/**
+ * @brief Hashes the members of a tar archive in a single forward pass, without extracting them.
+ *
+ * Supports ustar, pax (path, linkpath and size records) and GNU (long names and links, base-256 sizes) headers.
+ * The records are the same as walking the extracted tree would yield, in archive order. Hard links are reported as
+ * regular files with the digest of their target, directories are not reported. GNU volume labels and dumpdirs
+ * (incremental archives) and unknown member types are skipped, multi-volume archives are rejected.
+ *
+ * Only `Options::excludeNames`, `Options::readBufferSize`, `Options::gitBlob`, `Options::progress` (without totals) and
+ * `Options::rateLimiter` (member contents only) are used. A member is skipped if any of its path components is excluded.
+ * Errors in the archive are thrown as `std::runtime_error`.
+ *
+ * @param is Opened in binary mode, may be a pipe
+ */
+void hashTar(std::istream& is, const Options& options, const RecordCallback& callback);
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_TAR_H
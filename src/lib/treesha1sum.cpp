@@ -0,0 +1,810 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "checkpoint.h"
+#include "filter.h"
+#include "gitindex.h"
+#include "incremental.h"
+#include "manifest.h"
+#include "middleware/sha1.h"
+#include "progress.h"
+#include "ratelimit.h"
+#include "reader.h"
+#include "treesha1sum.h"
+
+#include <omw/defs.h>
+
+
+namespace fs = std::filesystem;
+
+using treesha1sum::Checkpoint;
+using treesha1sum::Filter;
+using treesha1sum::GitIndex;
+using treesha1sum::IncrementalState;
+using treesha1sum::IoMode;
+using treesha1sum::Options;
+using treesha1sum::Progress;
+using treesha1sum::RateLimiter;
+using treesha1sum::Record;
+using treesha1sum::Schedule;
+
+namespace io = treesha1sum::io;
+
+namespace {
+
+constexpr uint64_t progressStep = 1024 * 1024; // the progress counters are updated in batches of at least N bytes
+
+using EmitFunction = std::function<void(Record&& record)>;
+using ProgressFunction = std::function<void(uint64_t offset)>;
+
+// state of a single walk, shared by all hashing jobs
+struct Context
+{
+    const Options& options;
+    Checkpoint* checkpoint;
+    IncrementalState* incremental;
+    const GitIndex* gitIndex;
+    const treesha1sum::DigestMap* baseline;
+};
+
+bool isExcluded(const std::vector<std::string>& excludeNames, const fs::path& path)
+{
+    return (std::find(excludeNames.begin(), excludeNames.end(), treesha1sum::entryName(path)) != excludeNames.end());
+}
+
+/**
+ * @brief Creates the record of a non-directory entry. The digest is not yet calculated.
+ */
+Record makeRecord(const fs::path& path, const fs::file_status& stat)
+{
+    Record rec;
+    rec.path = path;
+    rec.type = stat.type();
+
+    if (fs::is_regular_file(stat))
+    {
+        rec.size = fs::file_size(path);
+        rec.mtime = treesha1sum::mtimeOf(path);
+    }
+    else if (fs::is_symlink(stat)) { rec.symlinkTarget = fs::weakly_canonical(fs::read_symlink(path)); }
+
+    return rec;
+}
+
+/**
+ * @brief Traverses the tree and emits a record for every non-directory entry which matches the filter.
+ */
+void traverse(const fs::path& path, size_t& depth, const Options& options, const Filter& filter, const EmitFunction& emit)
+{
+    ++depth;
+
+    const fs::file_status stat = fs::symlink_status(path);
+
+    if (fs::is_directory(stat))
+    {
+        // the root is at depth 1
+        if (filter.descend(path, depth - 1))
+        {
+            for (const auto& entry : fs::directory_iterator(path))
+            {
+                if (!isExcluded(options.excludeNames, entry.path())) { traverse(entry.path(), depth, options, filter, emit); }
+            }
+        }
+    }
+    else if (!isExcluded(options.excludeNames, path))
+    {
+        Record rec = makeRecord(path, stat);
+        if (filter.match(rec)) { emit(std::move(rec)); }
+    }
+
+    --depth;
+}
+
+/**
+ * @brief Reads a list of paths and emits a record for every non-directory entry, without traversing.
+ *
+ * The list is processed while it's being read, so that hashing can start before the end of the list is available.
+ */
+void readList(std::istream& list, char separator, const Options& options, const Filter& filter, const EmitFunction& emit)
+{
+    std::string line;
+
+    while (std::getline(list, line, separator))
+    {
+        if ((separator == '\n') && !line.empty() && (line.back() == '\r')) { line.pop_back(); }
+        if (line.empty()) { continue; }
+
+        const fs::path path = fs::u8path(line);
+
+        if (!isExcluded(options.excludeNames, path))
+        {
+            const fs::file_status stat = fs::symlink_status(path);
+
+            if (!fs::is_directory(stat))
+            {
+                Record rec = makeRecord(path, stat);
+                if (filter.match(rec)) { emit(std::move(rec)); }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Metadata-only traversal which sums up the regular files for `Progress::filesTotal` and `Progress::bytesTotal`.
+ *
+ * Runs concurrently with the walk on its own thread, so nothing may throw. Entries which can't be read are skipped, the
+ * errors are reported by the walk itself. `Progress::totalKnown` is only set if the whole tree has been scanned.
+ */
+void prescan(const fs::path& root, const Options& options, const Filter& filter, const std::atomic<bool>& stop) noexcept
+{
+    Progress* const progress = options.progress;
+    uint64_t files = 0, bytes = 0;
+
+    const auto publish = [&]() {
+        progress->filesTotal.fetch_add(files, std::memory_order_relaxed);
+        progress->bytesTotal.fetch_add(bytes, std::memory_order_relaxed);
+        files = 0;
+        bytes = 0;
+    };
+
+    const auto count = [&](const fs::path& path, uint64_t size) {
+        std::error_code ec;
+        const int64_t mtime = (filter.needsMtime() ? treesha1sum::mtimeOf(path, ec) : 0);
+
+        if (!ec && filter.match(fs::file_type::regular, size, mtime))
+        {
+            ++files;
+            bytes += size;
+        }
+    };
+
+    try
+    {
+        std::error_code ec;    // traversal errors, the totals are incomplete then
+        std::error_code entEc; // errors of single entries, they are skipped
+
+        const fs::file_status rootStat = fs::symlink_status(root, ec);
+
+        if (fs::is_regular_file(rootStat))
+        {
+            const uint64_t size = fs::file_size(root, entEc);
+            if (!entEc) { count(root, size); }
+        }
+        else if (fs::is_directory(rootStat) && filter.descend(root, 0))
+        {
+            fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+
+            for (; !ec && (it != fs::recursive_directory_iterator()) && !stop; it.increment(ec))
+            {
+                const fs::file_status stat = it->symlink_status(entEc);
+
+                if (entEc) { continue; }
+
+                if (isExcluded(options.excludeNames, it->path())) { it.disable_recursion_pending(); }
+                else if (fs::is_regular_file(stat))
+                {
+                    const uint64_t size = it->file_size(entEc);
+
+                    if (!entEc)
+                    {
+                        count(it->path(), size);
+                        if (files >= 1024) { publish(); }
+                    }
+                }
+                else if (fs::is_directory(stat) && !filter.descend(it->path(), (size_t)it.depth() + 1)) { it.disable_recursion_pending(); }
+            }
+        }
+
+        publish();
+
+        if (!stop && !ec) { progress->totalKnown = true; }
+    }
+    catch (...)
+    {
+        // the totals stay lower bounds
+    }
+}
+
+/**
+ * @brief Feeds the file from `offset` to the end into `sha1`.
+ *
+ * @param progress Called with the current offset after each chunk, only supported by the buffered I/O modes
+ */
+void hashInto(SHA1& sha1, const fs::path& path, const Options& options, uint64_t offset = 0, const ProgressFunction& progress = nullptr)
+{
+    // a resumed state already contains the header
+    if (options.gitBlob && (offset == 0)) { sha1.update(treesha1sum::gitBlobHeader(fs::file_size(path))); }
+
+    if (options.ioMode == IoMode::stream)
+    {
+        std::ifstream fstream(path, std::ios::binary);
+
+        if (!fstream.is_open()) { throw fs::filesystem_error("failed to open file", path, std::error_code(errno, std::generic_category())); }
+        if (offset > 0) { fstream.seekg((std::streamoff)offset); }
+
+        sha1.update(fstream);
+    }
+    else
+    {
+        std::vector<uint8_t> buffer(std::max<size_t>(options.readBufferSize, 1));
+        uint64_t pos = offset;
+        RateLimiter* const limiter = options.rateLimiter;
+
+        const io::DataSink sink = [&](const uint8_t* data, size_t count) {
+            if (limiter)
+            {
+                const auto t0 = std::chrono::steady_clock::now();
+                sha1.update(data, count);
+                limiter->cpu(std::chrono::steady_clock::now() - t0);
+            }
+            else { sha1.update(data, count); }
+
+            pos += count;
+            if (progress) { progress(pos); }
+        };
+
+        if (options.ioMode == IoMode::sparse) { io::readSparse(path, buffer, sink, offset, limiter); }
+        else { io::readBlock(path, buffer, sink, offset, limiter); }
+    }
+}
+
+/**
+ * @brief Quick-scan fingerprint, a SHA1 over the size, the layout parameters and some blocks of the file.
+ *
+ * The blocks are the head, the tail and `quickSamples` evenly spaced blocks in between, each `quickBlockSize` bytes.
+ * Overlapping blocks are merged, files smaller than the sum of the blocks are hashed completely.
+ */
+std::string quickFingerprint(const fs::path& path, uint64_t size, const Options& options)
+{
+    const uint64_t blockSize = std::max<uint64_t>(options.quickBlockSize, 1);
+    std::vector<std::pair<uint64_t, uint64_t>> ranges; // begin, end
+
+    ranges.push_back({ 0, std::min(blockSize, size) });
+
+    if (size > blockSize)
+    {
+        for (size_t i = 1; i <= options.quickSamples; ++i)
+        {
+            const uint64_t begin = (uint64_t)(((long double)(size - blockSize) * i) / (options.quickSamples + 1));
+            ranges.push_back({ begin, begin + blockSize });
+        }
+
+        ranges.push_back({ size - blockSize, size });
+    }
+
+    SHA1 sha1;
+    sha1.update("treesha1sum-quick " + std::to_string(size) + " " + std::to_string(blockSize) + " " + std::to_string(options.quickSamples) + "\n");
+
+    std::ifstream fstream(path, std::ios::binary);
+    if (!fstream.is_open()) { throw fs::filesystem_error("failed to open file", path, std::error_code(errno, std::generic_category())); }
+
+    std::vector<uint8_t> buffer((size_t)std::min<uint64_t>(blockSize, std::max<size_t>(options.readBufferSize, 1)));
+    uint64_t pos = 0; // end of the data hashed so far
+
+    for (const auto& range : ranges)
+    {
+        uint64_t begin = std::max(range.first, pos);
+
+        if (begin >= range.second) { continue; }
+
+        fstream.seekg((std::streamoff)begin);
+
+        while (fstream && (begin < range.second))
+        {
+            fstream.read((char*)buffer.data(), (std::streamsize)std::min<uint64_t>(range.second - begin, buffer.size()));
+            const size_t count = (size_t)fstream.gcount();
+            if (options.rateLimiter && (count > 0)) { options.rateLimiter->read(count); }
+            sha1.update(buffer.data(), count);
+            begin += count;
+        }
+
+        pos = begin;
+        fstream.clear();
+    }
+
+    return sha1.digest();
+}
+
+/**
+ * @brief Sets the digest of a regular file record.
+ */
+void hashRegular(Record& rec, const Context& ctx)
+{
+    const Options& options = ctx.options;
+    Progress* const progress = options.progress;
+    uint64_t reported = 0; // bytes of this file added to the progress counters
+
+    const auto report = [&](uint64_t pos) {
+        if (progress && (pos >= (reported + progressStep)))
+        {
+            progress->addBytes(pos - reported);
+            reported = pos;
+        }
+    };
+
+    if (ctx.gitIndex && ctx.gitIndex->lookup(rec.path, rec.size, rec.digest))
+    {
+        // unmodified since git has hashed it
+    }
+    else if (options.quick)
+    {
+        rec.digest = quickFingerprint(rec.path, rec.size, options);
+        rec.quick = true;
+
+        if (ctx.baseline)
+        {
+            const auto it = ctx.baseline->find(treesha1sum::pathStr(rec.path));
+
+            if ((it == ctx.baseline->end()) || (it->second != treesha1sum::digestStr(rec)))
+            {
+                SHA1 sha1;
+                hashInto(sha1, rec.path, options, 0, report);
+                rec.quickDigest = rec.digest;
+                rec.digest = sha1.digest();
+                rec.quick = false;
+            }
+        }
+    }
+    else if (!ctx.checkpoint && !ctx.incremental)
+    {
+        SHA1 sha1;
+        hashInto(sha1, rec.path, options, 0, report);
+        rec.digest = sha1.digest();
+    }
+    else
+    {
+        Checkpoint* const checkpoint = ctx.checkpoint;
+        IncrementalState* const incremental = ctx.incremental;
+        const int64_t mtime = rec.mtime;
+
+        if (!checkpoint || !checkpoint->findDone(rec.path, mtime, rec.size, rec.digest))
+        {
+            SHA1 sha1;
+            uint64_t offset = 0;
+            Checkpoint::Partial partial;
+
+            if (checkpoint && (options.ioMode != IoMode::stream) && checkpoint->findPartial(rec.path, mtime, rec.size, partial) &&
+                sha1.importState(partial.sha1State))
+            {
+                offset = partial.offset;
+            }
+            else if (incremental) { offset = incremental->resume(rec.path, mtime, rec.size, sha1); }
+
+            uint64_t lastSaved = offset;
+
+            hashInto(sha1, rec.path, options, offset, [&](uint64_t pos) {
+                if (checkpoint && ((pos - lastSaved) >= options.checkpointPartialStep))
+                {
+                    partial.offset = pos;
+                    partial.sha1State = sha1.exportState();
+                    checkpoint->partial(rec.path, mtime, rec.size, partial);
+                    lastSaved = pos;
+                }
+
+                report(pos);
+            });
+
+            if (incremental) { incremental->update(rec.path, mtime, rec.size, sha1); }
+
+            rec.digest = sha1.digest();
+            if (checkpoint) { checkpoint->done(rec.path, mtime, rec.size, rec.digest); }
+        }
+    }
+
+    if (progress) { progress->fileDone(rec.size - std::min(reported, rec.size)); }
+}
+
+} // namespace
+
+
+
+class treesha1sum::Walker::Impl
+{
+public:
+    explicit Impl(size_t nThreads)
+        : m_seq(0), m_stop(false)
+    {
+        for (size_t i = 0; i < nThreads; ++i) { m_threads.emplace_back(&Impl::m_worker, this); }
+    }
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lg(m_mtx);
+            m_stop = true;
+        }
+
+        m_cv.notify_all();
+
+        for (auto& t : m_threads) { t.join(); }
+    }
+
+    size_t threadCount() const { return m_threads.size(); }
+
+    /**
+     * @brief Queues a job, jobs with higher priority are run first, jobs of equal priority in submission order.
+     */
+    void submit(std::function<void()>&& job, uint64_t priority = 0)
+    {
+        {
+            std::lock_guard<std::mutex> lg(m_mtx);
+            m_queue.push_back({ priority, m_seq++, std::move(job) });
+            std::push_heap(m_queue.begin(), m_queue.end(), Job::runsAfter);
+        }
+
+        m_cv.notify_one();
+    }
+
+private:
+    struct Job
+    {
+        uint64_t priority;
+        uint64_t seq;
+        std::function<void()> fn;
+
+        static bool runsAfter(const Job& a, const Job& b) { return ((a.priority < b.priority) || ((a.priority == b.priority) && (a.seq > b.seq))); }
+    };
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::vector<Job> m_queue; // heap
+    uint64_t m_seq;
+    bool m_stop;
+
+    void m_worker()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mtx);
+                m_cv.wait(lock, [this] { return (m_stop || !m_queue.empty()); });
+
+                if (m_queue.empty()) { break; } // m_stop is set
+
+                std::pop_heap(m_queue.begin(), m_queue.end(), Job::runsAfter);
+                job = std::move(m_queue.back().fn);
+                m_queue.pop_back();
+            }
+
+            job();
+        }
+    }
+};
+
+treesha1sum::Walker::Walker(const Options& options)
+    : m_options(options), m_impl()
+{
+    const size_t nThreads = (m_options.threads == 0 ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : m_options.threads);
+
+    if (nThreads > 1) { m_impl = std::make_unique<Impl>(nThreads); }
+}
+
+treesha1sum::Walker::~Walker() {}
+
+void treesha1sum::Walker::walk(const fs::path& root, const RecordCallback& callback)
+{
+    size_t depth = 0;
+    std::unique_ptr<Checkpoint> checkpoint;
+
+    // a quick scan takes minutes, checkpoints are only useful for full hashing
+    if (!m_options.checkpointFile.empty() && !m_options.quick)
+    {
+        const char* const digestType = (m_options.gitBlob ? "git-blob" : "sha1");
+        checkpoint = std::make_unique<Checkpoint>(m_options.checkpointFile, root, digestType, m_options.resume, m_options.checkpointInterval);
+    }
+
+    // the pre-scan only reads metadata, it's done long before the hashing in most cases
+    std::atomic<bool> stopPrescan(false);
+    std::thread prescanThread;
+
+    const Filter filter(m_options, root);
+
+    if (m_options.progress) { prescanThread = std::thread(prescan, root, std::cref(m_options), std::cref(filter), std::cref(stopPrescan)); }
+
+    try
+    {
+        m_run([&](const EmitFunction& emit) { traverse(root, depth, m_options, filter, emit); }, root, checkpoint.get(), callback);
+    }
+    catch (...)
+    {
+        stopPrescan = true;
+        if (prescanThread.joinable()) { prescanThread.join(); }
+        throw;
+    }
+
+    if (prescanThread.joinable()) { prescanThread.join(); }
+
+    if (checkpoint) { checkpoint->finish(); }
+}
+
+void treesha1sum::Walker::walkList(std::istream& list, char separator, const RecordCallback& callback)
+{
+    // the listed paths are relative to the working directory
+    const Filter filter(m_options);
+
+    m_run([&](const EmitFunction& emit) { readList(list, separator, m_options, filter, emit); }, ".", nullptr, callback);
+}
+
+void treesha1sum::Walker::m_run(const SourceFunction& source, const fs::path& root, Checkpoint* checkpoint, const RecordCallback& callback)
+{
+    std::unique_ptr<DigestMap> baseline;
+
+    if (m_options.quick && !m_options.escalateBaseline.empty()) { baseline = std::make_unique<DigestMap>(loadManifest(m_options.escalateBaseline)); }
+
+    // like checkpoints, the incremental state is only useful for full hashing
+    std::unique_ptr<IncrementalState> incremental;
+
+    if (!m_options.incrementalFile.empty() && !m_options.quick && !m_options.gitBlob)
+    {
+        incremental = std::make_unique<IncrementalState>(m_options.incrementalFile, m_options.incrementalMinSize);
+    }
+
+    std::unique_ptr<GitIndex> gitIndex;
+
+    if (m_options.gitBlob && m_options.useGitIndex && !m_options.quick) { gitIndex = std::make_unique<GitIndex>(root); }
+
+    const Context ctx = { m_options, checkpoint, incremental.get(), gitIndex.get(), baseline.get() };
+
+    // escalated files are reported with the quick-scan fingerprint first, see `Walker`
+    const auto deliver = [&callback](const Record& rec) {
+        if (!rec.quickDigest.empty())
+        {
+            Record quickRec = rec;
+            quickRec.digest = rec.quickDigest;
+            quickRec.quick = true;
+            quickRec.quickDigest.clear();
+            callback(quickRec);
+        }
+
+        callback(rec);
+    };
+
+    // Disk-locality scheduling collects a batch of files and hashes them in the order they are stored on the disk.
+    const bool locality = (m_options.schedule == Schedule::diskLocality);
+    const size_t batchSize = std::max<size_t>(m_options.localityBatchSize, 1);
+
+    if (!m_impl)
+    {
+        std::vector<Record> batch;
+
+        const auto flush = [&]() {
+            std::vector<std::pair<uint64_t, size_t>> order; // location, index
+
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                if (batch[i].type == fs::file_type::regular) { order.push_back({ io::diskLocation(batch[i].path), i }); }
+            }
+
+            std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return (a.first < b.first); });
+
+            for (const auto& e : order) { hashRegular(batch[e.second], ctx); }
+            for (const auto& rec : batch) { deliver(rec); }
+
+            batch.clear();
+        };
+
+        source([&](Record&& rec) {
+            if (locality)
+            {
+                batch.push_back(std::move(rec));
+                if (batch.size() >= batchSize) { flush(); }
+            }
+            else
+            {
+                if (rec.type == fs::file_type::regular) { hashRegular(rec, ctx); }
+                deliver(rec);
+            }
+        });
+
+        flush();
+    }
+    else
+    {
+        // The records are queued in traversal order and delivered as soon as the front is done. The window limits the
+        // number of records in flight, so that memory does not grow with the tree size if hashing is slower than traversal.
+        // Largest-first scheduling needs to see the whole tree, the traversal is not throttled in that case. Jobs are
+        // submitted as soon as they are found, so hashing overlaps with the traversal. With disk-locality scheduling the
+        // jobs are submitted batch wise. The batch only counts regular files, other entries can fill the window while a job
+        // is still in the batch, `deliverPending()` submits the batch before it waits for such a job.
+        const bool largestFirst = (m_options.schedule == Schedule::largestFirst);
+        const size_t window = (largestFirst ? SIZE_MAX : ((m_impl->threadCount() * 16) + (locality ? batchSize : 0)));
+        std::deque<std::future<Record>> pending;
+
+        using Task = std::shared_ptr<std::packaged_task<Record()>>;
+        std::vector<std::pair<uint64_t, Task>> batch; // location, task
+
+        // set on error, the queued jobs are skipped instead of hashing the rest of the tree
+        std::atomic<bool> cancelled(false);
+
+        const auto flush = [&]() {
+            std::stable_sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) { return (a.first < b.first); });
+
+            for (const auto& e : batch)
+            {
+                const Task task = e.second;
+                m_impl->submit([task]() { (*task)(); });
+            }
+
+            batch.clear();
+        };
+
+        const auto deliverPending = [&](bool all) {
+            while (!pending.empty())
+            {
+                const bool ready = (pending.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+                if (!all && (pending.size() <= window) && !ready) { break; }
+
+                // the front may be a job of the batch, it has to be submitted before it can be waited for
+                if (!ready) { flush(); }
+
+                deliver(pending.front().get());
+                pending.pop_front();
+            }
+        };
+
+        try
+        {
+            source([&](Record&& rec) {
+                if (rec.type == fs::file_type::regular)
+                {
+                    const uint64_t priority = (largestFirst ? rec.size : 0);
+                    const uint64_t location = (locality ? io::diskLocation(rec.path) : 0);
+
+                    const Task task = std::make_shared<std::packaged_task<Record()>>([rec = std::move(rec), &ctx, &cancelled]() mutable {
+                        if (!cancelled.load(std::memory_order_relaxed)) { hashRegular(rec, ctx); }
+                        return std::move(rec);
+                    });
+
+                    pending.push_back(task->get_future());
+
+                    if (locality)
+                    {
+                        batch.push_back({ location, task });
+                        if (batch.size() >= batchSize) { flush(); }
+                    }
+                    else { m_impl->submit([task]() { (*task)(); }, priority); }
+                }
+                else
+                {
+                    std::promise<Record> done;
+                    done.set_value(std::move(rec));
+                    pending.push_back(done.get_future());
+                }
+
+                deliverPending(false);
+            });
+
+            flush();
+            deliverPending(true);
+        }
+        catch (...)
+        {
+            // The queued jobs reference the context, it must not be destroyed before they are done. Jobs which haven't
+            // started yet return without reading, so only the running ones are waited for. The futures of jobs which have
+            // not been submitted become ready (broken promise) as soon as their task is destroyed. The future of the failed
+            // job has no state anymore, its `get()` threw the exception.
+            cancelled.store(true, std::memory_order_relaxed);
+            batch.clear();
+            for (auto& f : pending)
+            {
+                if (f.valid()) { f.wait(); }
+            }
+            throw;
+        }
+    }
+
+    if (incremental) { incremental->save(); }
+}
+
+
+
+std::string treesha1sum::hashFile(const fs::path& path, const Options& options)
+{
+    SHA1 sha1;
+    hashInto(sha1, path, options);
+    return sha1.digest();
+}
+
+std::string treesha1sum::digestStr(const Record& record) { return (record.quick ? (quickPrefix + record.digest) : record.digest); }
+
+std::string treesha1sum::pathStr(const fs::path& path)
+{
+#ifdef OMW_PLAT_WIN
+    std::string r = path.lexically_normal().u8string();
+    std::replace(r.begin(), r.end(), '\\', '/');
+    return r;
+#else
+    return path.lexically_normal().u8string();
+#endif
+}
+
+std::string treesha1sum::entryName(const fs::path& path)
+{
+    std::string r;
+
+    if (path.has_filename()) { r = path.filename().u8string(); }
+    else { r = path.parent_path().filename().u8string(); }
+
+    return r;
+}
+
+std::string treesha1sum::toString(const fs::file_type& type)
+{
+    std::string str;
+
+    switch (type)
+    {
+    case fs::file_type::none:
+        str = "none";
+        break;
+
+    case fs::file_type::not_found:
+        str = "not found";
+        break;
+
+    case fs::file_type::regular:
+        str = "regular file";
+        break;
+
+    case fs::file_type::directory:
+        str = "directory";
+        break;
+
+    case fs::file_type::symlink:
+        str = "symlink";
+        break;
+
+    case fs::file_type::block:
+        str = "block device";
+        break;
+
+    case fs::file_type::character:
+        str = "character device";
+        break;
+
+    case fs::file_type::fifo:
+        str = "fifo/pipe";
+        break;
+
+    case fs::file_type::socket:
+        str = "socket";
+        break;
+
+    case fs::file_type::unknown:
+        str = "unknown";
+        break;
+
+    default:
+        str = "implementation-defined";
+        break;
+    }
+
+    return str;
+}
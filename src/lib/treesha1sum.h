@@ -0,0 +1,186 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+    Embeddable API of treesha1sum. The CLI in `/src/main.cpp` is a frontend to this.
+
+    Example:
+
+        treesha1sum::Options opt;
+        opt.excludeNames = { ".git" };
+        opt.threads = 4;
+
+        treesha1sum::Walker walker(opt); // the worker threads are kept alive and can be reused for several walks
+        walker.walk("some/dir", [](const treesha1sum::Record& rec) { ... });
+*/
+
+#ifndef IG_LIB_TREESHA1SUM_H
+#define IG_LIB_TREESHA1SUM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace treesha1sum {
+
+namespace fs = std::filesystem;
+
+enum class IoMode
+{
+    stream, // `std::ifstream` fed to `SHA1::update(std::istream&)`
+    block,  // reads `Options::readBufferSize` bytes at once and hashes them directly from the buffer
+    sparse, // like `block`, but holes of sparse files are hashed as zeros without reading them
+};
+
+enum class Schedule
+{
+    walkOrder,    // files are hashed in traversal order
+    largestFirst, // the largest known file is hashed first, so that a huge file found late doesn't extend the total runtime
+    diskLocality, // batches of files are read in the order they are stored on the disk, for rotational media
+};
+
+struct Progress;
+class RateLimiter;
+
+struct Options
+{
+    std::vector<std::string> excludeNames; // dir entry names to skip
+    size_t threads = 1;                    // number of hashing threads, 0 = hardware concurrency, 1 = hash on the calling thread
+    IoMode ioMode = IoMode::block;
+    size_t readBufferSize = 256 * 1024; // used by `IoMode::block` and `IoMode::sparse`
+
+    // the records are delivered in traversal order anyway, `largestFirst` is only relevant with more than one thread
+    Schedule schedule = Schedule::walkOrder;
+    size_t localityBatchSize = 4096; // number of files sorted at once by `Schedule::diskLocality`
+
+    // progress is journaled to this file if not empty, see `/src/lib/checkpoint.h`
+    fs::path checkpointFile;
+    bool resume = false;                                                // continue from `checkpointFile` if it exists
+    std::chrono::seconds checkpointInterval = std::chrono::seconds(30); // max time between flushes of the checkpoint to the disk
+    uint64_t checkpointPartialStep = 1024llu * 1024 * 1024;             // the intermediate SHA1 state of large files is saved every N bytes
+
+    // the SHA1 state of large files is kept in this file between runs if not empty, grown files are only hashed from the
+    // previous end on, see `/src/lib/incremental.h`. Not used with `gitBlob`, the blob header contains the file size.
+    fs::path incrementalFile;
+    uint64_t incrementalMinSize = 1024 * 1024; // the state of smaller files is not stored
+
+    // compute git blob ids (SHA1 of `blob <size>\0` followed by the content) instead of SHA1 digests, see `/src/lib/gitindex.h`
+    bool gitBlob = false;
+    bool useGitIndex = false; // take the blob ids of unmodified tracked files from `.git/index`, requires `gitBlob`
+
+    // compute quick-scan fingerprints instead of SHA1 digests, see `Record::quick`
+    bool quick = false;
+    uint64_t quickBlockSize = 64 * 1024; // size of the head, tail and sample blocks
+    size_t quickSamples = 4;             // number of sample blocks between head and tail
+    fs::path escalateBaseline;           // manifest, files whose quick fingerprint differs from it get the full SHA1 (see `Record::quickDigest`)
+
+    // find-style predicates, evaluated on the metadata before a file is read or a directory is entered, see `/src/lib/filter.h`.
+    // Used by `Walker::walk()` and `Walker::walkList()` (no depth and filesystem there).
+    uint64_t minSize = 0;
+    uint64_t maxSize = UINT64_MAX;
+    int64_t newerThan = INT64_MIN;    // mtime in nanoseconds since the Unix epoch, exclusive
+    int64_t olderThan = INT64_MAX;    // mtime in nanoseconds since the Unix epoch, exclusive
+    std::vector<fs::file_type> types; // types of the reported entries, empty = all
+    size_t maxDepth = SIZE_MAX;       // directory levels below the root which are walked, 1 = only the entries of the root (like `find -maxdepth`)
+    bool oneFileSystem = false;       // directories on other filesystems than the root are not entered
+
+    // progress counters are updated if not null, a tree walk also runs a metadata pre-scan for the totals, see `/src/lib/progress.h`
+    Progress* progress = nullptr;
+
+    // reads and hashing are throttled by this if not null, it's shared by all hashing threads, see `/src/lib/ratelimit.h`.
+    // Not used by `IoMode::stream`.
+    RateLimiter* rateLimiter = nullptr;
+};
+
+struct Record
+{
+    fs::path path;
+    fs::file_type type = fs::file_type::none;
+    uint64_t size = 0;       // only set for regular files
+    int64_t mtime = 0;       // modification time in nanoseconds since the Unix epoch, only set for regular files
+    std::string digest;      // hex string, only set for regular files
+    bool quick = false;      // `digest` is a quick-scan fingerprint and not the SHA1 of the file content
+    std::string quickDigest; // quick-scan fingerprint of an escalated file, `digest` is the SHA1 then
+    fs::path symlinkTarget;  // only set for symlinks
+};
+
+// prefix of quick-scan fingerprints in manifests, see `digestStr()`
+const char* const quickPrefix = "quick:";
+
+using RecordCallback = std::function<void(const Record& record)>;
+
+class Checkpoint;
+
+/**
+ * @brief Recursively walks a directory tree and hashes all regular files.
+ *
+ * Records are delivered to the callback in traversal order and always on the thread calling `walk()`, regardless of
+ * the number of hashing threads. Directories themselves are not reported. Filesystem errors are thrown as
+ * `fs::filesystem_error`.
+ *
+ * Files escalated to the full SHA1 (`Options::escalateBaseline`) are reported twice, first with the quick-scan
+ * fingerprint, then with the SHA1. The output can be used as the next baseline that way.
+ */
+class Walker
+{
+public:
+    explicit Walker(const Options& options = Options());
+    ~Walker();
+
+    Walker(const Walker& other) = delete;
+    Walker& operator=(const Walker& other) = delete;
+
+    const Options& options() const { return m_options; }
+
+    void walk(const fs::path& root, const RecordCallback& callback);
+
+    /**
+     * @brief Hashes the listed paths instead of walking a tree, e.g. the output of `git ls-files -z`.
+     *
+     * The list is read as a stream, hashing starts before its end is reached. Listed directories are skipped,
+     * excludes apply to the listed entry names. Checkpoints are not supported.
+     *
+     * @param separator `'\0'` or `'\n'`
+     */
+    void walkList(std::istream& list, char separator, const RecordCallback& callback);
+
+private:
+    class Impl;
+
+    using EmitFunction = std::function<void(Record&& record)>;
+    using SourceFunction = std::function<void(const EmitFunction& emit)>;
+
+    Options m_options;
+    std::unique_ptr<Impl> m_impl;
+
+    void m_run(const SourceFunction& source, const fs::path& root, Checkpoint* checkpoint, const RecordCallback& callback);
+};
+
+/**
+ * @brief Computes the SHA1 digest of a single file.
+ */
+std::string hashFile(const fs::path& path, const Options& options = Options());
+
+/**
+ * @brief The digest as written to manifests, quick-scan fingerprints are prefixed with `quickPrefix`.
+ */
+std::string digestStr(const Record& record);
+
+std::string pathStr(const fs::path& path);
+std::string entryName(const fs::path& path);
+std::string toString(const fs::file_type& type);
+
+} // namespace treesha1sum
+
+
+#endif // IG_LIB_TREESHA1SUM_H
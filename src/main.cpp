@@ -4,13 +4,26 @@ date            22.12.2024
 copyright       GPL-3.0 - Copyright (c) 2024 Oliver Blaser
 */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "lib/manifest.h"
+#include "lib/progress.h"
+#include "lib/ratelimit.h"
+#include "lib/tar.h"
+#include "lib/treesha1sum.h"
 #include "middleware/sha1.h"
 #include "project.h"
 
@@ -19,6 +32,13 @@ copyright       GPL-3.0 - Copyright (c) 2024 Oliver Blaser
 #include <omw/vector.h>
 #include <omw/windows/windows.h>
 
+#ifdef OMW_PLAT_WIN
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 
 using std::cout;
 using std::endl;
@@ -30,6 +50,38 @@ namespace argstr {
 
 // const char* const changeDir = "--cd";
 const char* const exclude = "--exclude";
+const char* const minSize = "--min-size";
+const char* const maxSize = "--max-size";
+const char* const newerThan = "--newer-than";
+const char* const olderThan = "--older-than";
+const char* const type = "--type";
+const char* const maxDepth = "--max-depth";
+const char* const oneFileSystem = "--one-file-system";
+const char* const threads = "--threads";
+const char* const io = "--io";
+const char* const schedule = "--schedule";
+const char* const checkpoint = "--checkpoint";
+const char* const resume = "--resume";
+const char* const incremental = "--incremental";
+const char* const gitBlob = "--git-blob";
+const char* const useGitIndex = "--use-git-index";
+const char* const quick = "--quick";
+const char* const quickSize = "--quick-size";
+const char* const quickSamples = "--quick-samples";
+const char* const escalate = "--escalate";
+const char* const tar = "--tar";
+const char* const filesFrom = "--files-from";
+const char* const null = "--null";
+const char* const fromText = "--from-text";
+const char* const fromBinary = "--from-binary";
+const char* const lookup = "--lookup";
+const char* const binary = "--binary";
+const char* const maxReadRate = "--max-read-rate";
+const char* const maxIops = "--max-iops";
+const char* const maxCpu = "--max-cpu";
+const char* const idleIo = "--idle-io";
+const char* const progress = "--progress";
+const char* const progressLog = "--progress-log";
 const char* const noColor = "--no-color";
 const char* const help = "--help";
 const char* const version = "--version";
@@ -50,7 +102,24 @@ bool contains(const std::vector<std::string>& rawArgs, const char* arg)
     return r;
 }
 
-bool isOption(const std::string& arg) { return (/*(arg == changeDir) ||*/ (arg == exclude) || (arg == noColor) || (arg == help) || (arg == version)); }
+bool isOption(const std::string& arg)
+{
+    return (/*(arg == changeDir) ||*/ (arg == exclude) || (arg == minSize) || (arg == maxSize) || (arg == newerThan) || (arg == olderThan) || (arg == type) ||
+            (arg == maxDepth) || (arg == oneFileSystem) || (arg == threads) || (arg == io) || (arg == schedule) || (arg == checkpoint) || (arg == resume) ||
+            (arg == incremental) || (arg == gitBlob) || (arg == useGitIndex) || (arg == quick) || (arg == quickSize) || (arg == quickSamples) ||
+            (arg == escalate) || (arg == tar) || (arg == filesFrom) || (arg == null) || (arg == fromText) || (arg == fromBinary) || (arg == lookup) ||
+            (arg == binary) || (arg == maxReadRate) || (arg == maxIops) || (arg == maxCpu) || (arg == idleIo) || (arg == progress) || (arg == progressLog) ||
+            (arg == noColor) || (arg == help) || (arg == version));
+}
+
+// options which are followed by a value
+bool hasValue(const std::string& arg)
+{
+    return ((arg == exclude) || (arg == minSize) || (arg == maxSize) || (arg == newerThan) || (arg == olderThan) || (arg == type) || (arg == maxDepth) ||
+            (arg == threads) || (arg == io) || (arg == schedule) || (arg == checkpoint) || (arg == incremental) || (arg == quickSize) ||
+            (arg == quickSamples) || (arg == escalate) || (arg == tar) || (arg == filesFrom) || (arg == fromText) || (arg == fromBinary) || (arg == lookup) ||
+            (arg == binary) || (arg == maxReadRate) || (arg == maxIops) || (arg == maxCpu) || (arg == progressLog));
+}
 
 } // namespace argstr
 
@@ -87,6 +156,62 @@ void printHelp()
     // cout << std::left << setw(lw) << std::string("  ") + argstr::changeDir << "change to DIRECTORY before executing" << endl;
     cout << std::left << setw(lw) << std::string("  ") + argstr::exclude + " NAMES"
          << "one or more dir entry names to skip, separated by pipe, e.g. \".git|sdk\"" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::minSize + " SIZE"
+         << "only regular files of at least SIZE bytes, with optional suffix K, M or G (1024)" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::maxSize + " SIZE" << "only regular files of at most SIZE bytes" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::newerThan + " AGE"
+         << "only regular files modified less than AGE ago, N with suffix s, m, h, d or w, or \"@\" and a Unix timestamp" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::olderThan + " AGE" << "only regular files modified more than AGE ago" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::type + " TYPES"
+         << "only entries of these types, separated by comma: f (regular), l (symlink), p (fifo), s (socket), b (block), c (character)" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::maxDepth + " N"
+         << "descend at most N directory levels, 1 = only the entries of DIRECTORY" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::oneFileSystem << "don't enter directories on other filesystems than DIRECTORY" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::threads + " N"
+         << "number of hashing threads, 0 = one per CPU (default 1)" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::io + " MODE"
+         << "how files are read: \"block\" (default), \"sparse\" (skips holes) or \"stream\"" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::schedule + " MODE"
+         << "order in which the files are hashed: \"walk\" (default), \"largest\" (largest first, with --threads) or \"disk\" (by location on disk, for HDDs)"
+         << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::checkpoint + " FILE"
+         << "periodically save the progress to FILE, it's deleted when done" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::resume << "continue from the --checkpoint FILE if it exists" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::incremental + " FILE"
+         << "keep the SHA1 state of large files in FILE, grown files (logs) are only hashed from the previous end on" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::gitBlob << "git blob ids (like \"git hash-object\") instead of SHA1 digests" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::useGitIndex
+         << "take the blob ids of unmodified tracked files from .git/index, with --git-blob" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::quick << "quick-scan fingerprints of size, head, tail and samples (NOT SHA1), printed as \""
+         << treesha1sum::quickPrefix << "<hex>\"" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::quickSize + " KIB"
+         << "size of the quick-scan blocks (default 64)" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::quickSamples + " N"
+         << "number of quick-scan sample blocks between head and tail (default 4)" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::escalate + " FILE"
+         << "quick-scan: full SHA1 of files whose fingerprint differs from the manifest FILE" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::tar + " FILE"
+         << "hash the members of the tar archive FILE instead of a DIRECTORY, \"-\" reads from stdin" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::filesFrom + " FILE"
+         << "hash the paths listed in FILE (one per line) instead of a DIRECTORY, \"-\" reads from stdin" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::null << "the --files-from list is NUL separated, e.g. \"git ls-files -z\"" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::fromText + " FILE"
+         << "read the records from the text manifest FILE instead of a DIRECTORY, \"-\" reads from stdin" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::fromBinary + " FILE"
+         << "read the records from the binary manifest FILE instead of a DIRECTORY" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::lookup + " PATH"
+         << "with --from-binary: only the file PATH or the files below the directory PATH" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::binary + " FILE"
+         << "write a binary manifest (sorted by path) to FILE instead of the text output" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::maxReadRate + " RATE"
+         << "max bytes read per second, with optional suffix K, M or G (1024), e.g. \"20M\"" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::maxIops + " N" << "max read operations per second" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::maxCpu + " PERCENT"
+         << "max CPU time used for hashing, in percent of one core (may be > 100 with --threads)" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::idleIo << "idle I/O priority, only read when the disk isn't used otherwise" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::progress << "status line with ETA on stderr, only if stderr is a terminal" << endl;
+    cout << std::left << setw(lw) << std::string("  ") + argstr::progressLog + " SEC"
+         << "machine-readable progress line on stderr every SEC seconds" << endl;
     cout << std::left << setw(lw) << std::string("  ") + argstr::noColor << "monochrome console output" << endl;
     cout << std::left << setw(lw) << std::string("  ") + argstr::help << "prints this help text" << endl;
     cout << std::left << setw(lw) << std::string("  ") + argstr::version << "prints version info" << endl;
@@ -94,6 +219,172 @@ void printHelp()
     cout << "Website: <" << prj::website << ">" << endl;
 }
 
+void printError(const std::string& msg)
+{
+    cout << omw::fgBrightRed << "E" << omw::fgDefault;
+    cout << " " << msg << endl;
+}
+
+// on stderr, the output may be a manifest
+void printWarning(const std::string& msg)
+{
+    std::cerr << omw::fgBrightYellow << "W" << omw::fgDefault;
+    std::cerr << " " << msg << endl;
+}
+
+// achieved rates, on stderr like the progress
+void printRateStats(const treesha1sum::RateLimiter::Stats& stats)
+{
+    const double elapsed = std::max(std::chrono::duration<double>(stats.elapsed).count(), 1e-3);
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "read " << stats.bytes << " bytes in " << elapsed << " s: " << ((double)stats.bytes / elapsed / 1e6) << " MB/s, "
+        << ((double)stats.ops / elapsed) << " IOPS, CPU " << (std::chrono::duration<double>(stats.cpu).count() / elapsed * 100.0) << " %, throttled "
+        << std::chrono::duration<double>(stats.throttled).count() << " s";
+
+    std::cerr << oss.str() << endl;
+}
+
+bool parseUInt(const std::string& str, uint64_t& value)
+{
+    bool ok = !str.empty();
+    uint64_t tmp = 0;
+
+    for (size_t i = 0; ok && (i < str.size()); ++i)
+    {
+        const char c = str[i];
+
+        if ((c >= '0') && (c <= '9') && (tmp <= ((UINT64_MAX - 9) / 10))) { tmp = (tmp * 10) + (uint64_t)(c - '0'); }
+        else { ok = false; }
+    }
+
+    if (ok) { value = tmp; }
+
+    return ok;
+}
+
+// number with optional binary suffix K, M or G in upper or lower case, e.g. "20M"
+bool parseSize(const std::string& str, uint64_t& value)
+{
+    std::string digits = str;
+    uint64_t unit = 1;
+
+    if (!digits.empty())
+    {
+        const char c = digits.back();
+
+        if ((c == 'K') || (c == 'k')) { unit = 1024; }
+        else if ((c == 'M') || (c == 'm')) { unit = 1024 * 1024; }
+        else if ((c == 'G') || (c == 'g')) { unit = 1024 * 1024 * 1024; }
+
+        if (unit > 1) { digits.pop_back(); }
+    }
+
+    uint64_t tmp;
+    const bool ok = (parseUInt(digits, tmp) && (tmp <= (UINT64_MAX / unit)));
+
+    if (ok) { value = tmp * unit; }
+
+    return ok;
+}
+
+/**
+ * @brief Parses an age relative to now (`7d`) or a Unix timestamp (`@1700000000`).
+ *
+ * @param value Nanoseconds since the Unix epoch
+ */
+bool parseTime(const std::string& str, int64_t& value)
+{
+    bool ok = (str.size() > 1);
+    uint64_t n = 0;
+    int64_t seconds = 0;
+
+    if (ok && (str[0] == '@'))
+    {
+        ok = (parseUInt(str.substr(1), n) && (n <= (uint64_t)(INT64_MAX / 1000000000)));
+        seconds = (int64_t)n;
+    }
+    else if (ok)
+    {
+        uint64_t unit = 0;
+
+        switch (str.back())
+        {
+        case 's':
+            unit = 1;
+            break;
+
+        case 'm':
+            unit = 60;
+            break;
+
+        case 'h':
+            unit = 3600;
+            break;
+
+        case 'd':
+            unit = 24 * 3600;
+            break;
+
+        case 'w':
+            unit = 7 * 24 * 3600;
+            break;
+
+        default:
+            break;
+        }
+
+        const int64_t now = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        ok = ((unit != 0) && parseUInt(str.substr(0, str.size() - 1), n) && (n <= ((uint64_t)now / unit)));
+        seconds = now - (int64_t)(n * unit);
+    }
+
+    if (ok) { value = seconds * 1000000000; }
+
+    return ok;
+}
+
+bool parseTypes(const std::string& str, std::vector<fs::file_type>& types)
+{
+    bool ok = true;
+    std::vector<fs::file_type> tmp;
+
+    for (const auto& t : omw::stdStringVector(omw::split(str, ',')))
+    {
+        if (t == "f") { tmp.push_back(fs::file_type::regular); }
+        else if (t == "l") { tmp.push_back(fs::file_type::symlink); }
+        else if (t == "p") { tmp.push_back(fs::file_type::fifo); }
+        else if (t == "s") { tmp.push_back(fs::file_type::socket); }
+        else if (t == "b") { tmp.push_back(fs::file_type::block); }
+        else if (t == "c") { tmp.push_back(fs::file_type::character); }
+        else { ok = false; }
+    }
+
+    if (ok && !tmp.empty()) { types = tmp; }
+
+    return (ok && !tmp.empty());
+}
+
+bool isTerminal(FILE* stream)
+{
+#ifdef OMW_PLAT_WIN
+    return (_isatty(_fileno(stream)) != 0);
+#else
+    return (isatty(fileno(stream)) != 0);
+#endif
+}
+
+fs::path toPath(const std::string& str)
+{
+#ifdef OMW_PLAT_WIN
+    return omw::windows::u8tows(str);
+#else
+    return str;
+#endif
+}
+
 void printUsageAndTryHelp()
 {
     cout << "Usage: " << usageString << "\n\n";
@@ -126,10 +417,7 @@ void printVersion()
 
 
 static bool checkArgs(const std::vector<std::string>& args);
-static void process(const fs::path& dir, size_t& depth, const std::vector<std::string>& excludeNames);
-static std::string pathStr(const fs::path& path);
-static std::string entryName(const fs::path& path);
-static std::string toString(const fs::file_type& type);
+static void printRecord(const treesha1sum::Record& record);
 
 
 
@@ -266,60 +554,389 @@ int main(int argc, char** argv)
         else if (argstr::contains(args, argstr::version)) printVersion();
         else
         {
-            size_t dirArgIdx = 0;
-            std::vector<std::string> excludeNames;
+            std::string dir = ".";
+            bool dirGiven = false;
+            std::string tarFile;
+            std::string listFile;
+            bool nullSeparated = false;
+            std::string textManifest;
+            std::string binaryManifest;
+            std::string lookupPath;
+            std::string binaryOutput;
+            uint64_t maxReadRate = 0;
+            uint64_t maxIops = 0;
+            uint64_t maxCpu = 0;
+            bool idleIo = false;
+            bool progressLine = false;
+            uint64_t progressLogInterval = 0;
+            treesha1sum::Options options;
 
             for (size_t i = 0; (r == EC_OK) && (i < args.size()); ++i)
             {
-                if (args[i] == argstr::exclude)
-                {
-                    ++dirArgIdx;
+                const std::string& arg = args[i];
 
-                    if ((args.size() > 1) && (i <= (args.size() - 3)))
+                if (argstr::hasValue(arg))
+                {
+                    if ((i + 1) >= args.size())
                     {
-                        ++dirArgIdx;
+                        printError("missing value of " + arg);
+                        r = EC_ERROR;
+                        break;
+                    }
+
+                    ++i;
+                    const std::string& value = args[i];
 
-                        if (omw::contains(args[i + 1], '/')
+                    if (arg == argstr::exclude)
+                    {
+                        if (omw::contains(value, '/')
 #ifdef OMW_PLAT_WIN
-                            || omw::contains(args[i + 1], '\\')
+                            || omw::contains(value, '\\')
 #endif
                         )
                         {
-                            cout << omw::fgBrightRed << "E" << omw::fgDefault;
-                            cout << " path or partial path patterns can't be used in the exclude argument" << endl;
+                            printError("path or partial path patterns can't be used in the exclude argument");
                             r = EC_ERROR;
                         }
                         else
                         {
-                            const auto tmp = omw::stdStringVector(omw::split(args[i + 1], '|'));
+                            const auto tmp = omw::stdStringVector(omw::split(value, '|'));
 
-                            for (const auto& e : tmp) { excludeNames.push_back(e); }
+                            for (const auto& e : tmp) { options.excludeNames.push_back(e); }
                         }
                     }
-                    else
+                    else if ((arg == argstr::minSize) || (arg == argstr::maxSize))
                     {
-                        cout << omw::fgBrightRed << "E" << omw::fgDefault;
-                        cout << " missing exclude NAMES" << endl;
-                        r = EC_ERROR;
+                        if (!parseSize(value, ((arg == argstr::minSize) ? options.minSize : options.maxSize)))
+                        {
+                            printError("invalid size: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if ((arg == argstr::newerThan) || (arg == argstr::olderThan))
+                    {
+                        if (!parseTime(value, ((arg == argstr::newerThan) ? options.newerThan : options.olderThan)))
+                        {
+                            printError("invalid age: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::type)
+                    {
+                        if (!parseTypes(value, options.types))
+                        {
+                            printError("invalid types: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::maxDepth)
+                    {
+                        uint64_t n;
+
+                        if (parseUInt(value, n)) { options.maxDepth = (size_t)std::min<uint64_t>(n, SIZE_MAX); }
+                        else
+                        {
+                            printError("invalid depth: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::threads)
+                    {
+                        uint64_t n;
+
+                        if (parseUInt(value, n) && (n <= 1024)) { options.threads = (size_t)n; }
+                        else
+                        {
+                            printError("invalid number of threads: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::io)
+                    {
+                        if (value == "block") { options.ioMode = treesha1sum::IoMode::block; }
+                        else if (value == "sparse") { options.ioMode = treesha1sum::IoMode::sparse; }
+                        else if (value == "stream") { options.ioMode = treesha1sum::IoMode::stream; }
+                        else
+                        {
+                            printError("unknown I/O mode: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
                     }
+                    else if (arg == argstr::schedule)
+                    {
+                        if (value == "walk") { options.schedule = treesha1sum::Schedule::walkOrder; }
+                        else if (value == "largest") { options.schedule = treesha1sum::Schedule::largestFirst; }
+                        else if (value == "disk") { options.schedule = treesha1sum::Schedule::diskLocality; }
+                        else
+                        {
+                            printError("unknown schedule: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::checkpoint) { options.checkpointFile = toPath(value); }
+                    else if (arg == argstr::incremental) { options.incrementalFile = toPath(value); }
+                    else if (arg == argstr::quickSize)
+                    {
+                        uint64_t n;
+
+                        if (parseUInt(value, n) && (n > 0) && (n <= (1024 * 1024))) { options.quickBlockSize = n * 1024; }
+                        else
+                        {
+                            printError("invalid quick-scan block size: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::quickSamples)
+                    {
+                        uint64_t n;
+
+                        if (parseUInt(value, n) && (n <= 1024)) { options.quickSamples = (size_t)n; }
+                        else
+                        {
+                            printError("invalid number of quick-scan samples: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::escalate) { options.escalateBaseline = toPath(value); }
+                    else if (arg == argstr::tar) { tarFile = value; }
+                    else if (arg == argstr::filesFrom) { listFile = value; }
+                    else if (arg == argstr::fromText) { textManifest = value; }
+                    else if (arg == argstr::fromBinary) { binaryManifest = value; }
+                    else if (arg == argstr::lookup) { lookupPath = value; }
+                    else if (arg == argstr::binary) { binaryOutput = value; }
+                    else if (arg == argstr::maxReadRate)
+                    {
+                        if (!parseSize(value, maxReadRate) || (maxReadRate == 0))
+                        {
+                            printError("invalid read rate: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::maxIops)
+                    {
+                        if (!parseUInt(value, maxIops) || (maxIops == 0))
+                        {
+                            printError("invalid number of read operations: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::maxCpu)
+                    {
+                        if (!parseUInt(value, maxCpu) || (maxCpu == 0) || (maxCpu > (1024 * 100)))
+                        {
+                            printError("invalid CPU percentage: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                    else if (arg == argstr::progressLog)
+                    {
+                        if (!parseUInt(value, progressLogInterval) || (progressLogInterval == 0) || (progressLogInterval > (24 * 3600)))
+                        {
+                            printError("invalid progress log interval: \"" + value + "\"");
+                            r = EC_ERROR;
+                        }
+                    }
+                }
+                else if (arg == argstr::oneFileSystem) { options.oneFileSystem = true; }
+                else if (arg == argstr::resume) { options.resume = true; }
+                else if (arg == argstr::gitBlob) { options.gitBlob = true; }
+                else if (arg == argstr::useGitIndex) { options.useGitIndex = true; }
+                else if (arg == argstr::quick) { options.quick = true; }
+                else if (arg == argstr::null) { nullSeparated = true; }
+                else if (arg == argstr::idleIo) { idleIo = true; }
+                else if (arg == argstr::progress) { progressLine = true; }
+                else if (!argstr::isOption(arg))
+                {
+                    dir = arg;
+                    dirGiven = true;
                 }
             }
 
+            if ((r == EC_OK) && options.resume && options.checkpointFile.empty())
+            {
+                printError(std::string(argstr::resume) + " requires " + argstr::checkpoint);
+                r = EC_ERROR;
+            }
+
+            if ((r == EC_OK) && !options.escalateBaseline.empty() && !options.quick)
+            {
+                printError(std::string(argstr::escalate) + " requires " + argstr::quick);
+                r = EC_ERROR;
+            }
+
+            if ((r == EC_OK) && options.useGitIndex && !options.gitBlob)
+            {
+                printError(std::string(argstr::useGitIndex) + " requires " + argstr::gitBlob);
+                r = EC_ERROR;
+            }
+
+            if ((r == EC_OK) && options.gitBlob && (options.quick || !options.incrementalFile.empty()))
+            {
+                printError(std::string(argstr::gitBlob) + " can't be used with " + argstr::quick + " or " + argstr::incremental);
+                r = EC_ERROR;
+            }
+
+            if ((r == EC_OK) && options.useGitIndex && !tarFile.empty())
+            {
+                printError(std::string(argstr::useGitIndex) + " can't be used with " + argstr::tar);
+                r = EC_ERROR;
+            }
+
+            // checkpoints are only written by full hashing of a DIRECTORY
+            if ((r == EC_OK) && !options.checkpointFile.empty() &&
+                (options.quick || !tarFile.empty() || !listFile.empty() || !textManifest.empty() || !binaryManifest.empty()))
+            {
+                printError(std::string(argstr::checkpoint) + " can't be used with " + argstr::quick + ", " + argstr::tar + ", " + argstr::filesFrom + ", " +
+                           argstr::fromText + " or " + argstr::fromBinary);
+                r = EC_ERROR;
+            }
+
+            if ((r == EC_OK) &&
+                (((int)!tarFile.empty() + (int)!listFile.empty() + (int)!textManifest.empty() + (int)!binaryManifest.empty() + (int)dirGiven) > 1))
+            {
+                printError(std::string("only one of DIRECTORY, ") + argstr::tar + ", " + argstr::filesFrom + ", " + argstr::fromText + " and " +
+                           argstr::fromBinary + " can be used");
+                r = EC_ERROR;
+            }
+
+            const bool rateLimited = ((maxReadRate > 0) || (maxIops > 0) || (maxCpu > 0));
+
+            if ((r == EC_OK) && rateLimited && (options.ioMode == treesha1sum::IoMode::stream))
+            {
+                printError(std::string(argstr::maxReadRate) + ", " + argstr::maxIops + " and " + argstr::maxCpu + " can't be used with " + argstr::io +
+                           " stream");
+                r = EC_ERROR;
+            }
+
+            const bool filtered = ((options.minSize != 0) || (options.maxSize != UINT64_MAX) || (options.newerThan != INT64_MIN) ||
+                                   (options.olderThan != INT64_MAX) || !options.types.empty() || (options.maxDepth != SIZE_MAX) || options.oneFileSystem);
+
+            if ((r == EC_OK) && filtered && (!tarFile.empty() || !textManifest.empty() || !binaryManifest.empty()))
+            {
+                printError("the filters can only be used with DIRECTORY or " + std::string(argstr::filesFrom));
+                r = EC_ERROR;
+            }
+
+            if ((r == EC_OK) && nullSeparated && listFile.empty())
+            {
+                printError(std::string(argstr::null) + " requires " + argstr::filesFrom);
+                r = EC_ERROR;
+            }
+
+            // a file list has no directory levels
+            if ((r == EC_OK) && ((options.maxDepth != SIZE_MAX) || options.oneFileSystem) && !listFile.empty())
+            {
+                printError(std::string(argstr::maxDepth) + " and " + argstr::oneFileSystem + " can't be used with " + argstr::filesFrom);
+                r = EC_ERROR;
+            }
+
+            if ((r == EC_OK) && !lookupPath.empty() && binaryManifest.empty())
+            {
+                printError(std::string(argstr::lookup) + " requires " + argstr::fromBinary);
+                r = EC_ERROR;
+            }
+
             if (r == EC_OK)
             {
-                std::string dir = ((dirArgIdx == args.size()) ? "." : args.back());
-                size_t depth = 0;
+                try
+                {
+                    treesha1sum::Progress progress;
+                    std::unique_ptr<treesha1sum::ProgressMeter> meter;
 
-                if (argstr::isOption(dir)) { dir = "."; }
+                    // the machine-readable log is written regardless of the terminal, the status line would garble a log file
+                    if (progressLogInterval > 0)
+                    {
+                        meter = std::make_unique<treesha1sum::ProgressMeter>(progress, std::cerr, treesha1sum::ProgressMeter::Style::log,
+                                                                             std::chrono::seconds(progressLogInterval));
+                    }
+                    else if (progressLine && isTerminal(stderr))
+                    {
+                        meter = std::make_unique<treesha1sum::ProgressMeter>(progress, std::cerr, treesha1sum::ProgressMeter::Style::statusLine,
+                                                                             std::chrono::milliseconds(250));
+                    }
+
+                    if (meter) { options.progress = &progress; }
+
+                    // before the walker creates the hashing threads, they inherit the priority
+                    if (idleIo && !treesha1sum::setIdleIoPriority()) { printWarning("failed to set the idle I/O priority"); }
+
+                    std::unique_ptr<treesha1sum::RateLimiter> limiter;
 
-                const fs::path dirPath =
+                    if (rateLimited)
+                    {
+                        limiter = std::make_unique<treesha1sum::RateLimiter>(maxReadRate, maxIops, (double)maxCpu / 100.0);
+                        options.rateLimiter = limiter.get();
+                    }
+
+                    std::unique_ptr<treesha1sum::BinaryManifestWriter> writer;
+                    treesha1sum::RecordCallback output = printRecord;
+
+                    if (!binaryOutput.empty())
+                    {
+                        writer = std::make_unique<treesha1sum::BinaryManifestWriter>(toPath(binaryOutput));
+                        output = [&writer](const treesha1sum::Record& record) { writer->add(record); };
+                    }
+
+                    const std::string& inFile = (!tarFile.empty() ? tarFile : (!listFile.empty() ? listFile : textManifest));
+                    std::ifstream ifs;
+                    std::istream* is = &std::cin;
+
+                    if (inFile == "-")
+                    {
 #ifdef OMW_PLAT_WIN
-                    omw::windows::u8tows(dir);
-#else
-                    dir;
+                        _setmode(_fileno(stdin), _O_BINARY);
 #endif
+                    }
+                    else if (!inFile.empty())
+                    {
+                        ifs.open(toPath(inFile), std::ios::binary);
+                        if (!ifs.is_open()) { throw std::runtime_error("failed to open \"" + inFile + "\""); }
+
+                        is = &ifs;
+                    }
 
-                process(dirPath, depth, excludeNames);
+                    if (!tarFile.empty()) { treesha1sum::hashTar(*is, options, output); }
+                    else if (!listFile.empty())
+                    {
+                        treesha1sum::Walker walker(options);
+                        walker.walkList(*is, (nullSeparated ? '\0' : '\n'), output);
+                    }
+                    else if (!textManifest.empty())
+                    {
+                        std::string line;
+                        treesha1sum::Record record;
+
+                        while (std::getline(*is, line))
+                        {
+                            if (treesha1sum::parseManifestLine(line, record)) { output(record); }
+                        }
+                    }
+                    else if (!binaryManifest.empty())
+                    {
+                        const treesha1sum::BinaryManifest manifest(toPath(binaryManifest));
+                        const std::string path = (lookupPath.empty() ? std::string() : treesha1sum::pathStr(toPath(lookupPath)));
+                        treesha1sum::Record record;
+
+                        if ((path == ".") || path.empty()) { manifest.forEach("", output); }
+                        else if (manifest.find(path, record)) { output(record); }
+                        else { manifest.forEach(path, output); }
+                    }
+                    else
+                    {
+                        treesha1sum::Walker walker(options);
+                        walker.walk(toPath(dir), output);
+                    }
+
+                    if (writer) { writer->finish(); }
+                    if (meter) { meter->stop(); }
+                    if (limiter) { printRateStats(limiter->stats()); }
+                }
+                catch (const std::exception& ex)
+                {
+                    cout << std::flush;
+                    printError(ex.what());
+                    r = EC_ERROR;
+                }
             }
         }
     }
@@ -383,7 +1000,7 @@ bool checkArgs(const std::vector<std::string>& args)
                     cout << "unknown option: \"" << arg << "\"" << endl;
                 }
             }
-            else if (arg == argstr::exclude) { expectString = true; }
+            else if (argstr::hasValue(arg)) { expectString = true; }
         }
     }
 
@@ -396,129 +1013,4 @@ bool checkArgs(const std::vector<std::string>& args)
     return ok;
 }
 
-void process(const fs::path& path, size_t& depth, const std::vector<std::string>& excludeNames)
-{
-    ++depth;
-
-    const fs::file_status stat = fs::symlink_status(path);
-
-    if (fs::is_directory(stat))
-    {
-        for (const auto& entry : std::filesystem::directory_iterator(path))
-        {
-            if (!omw::contains(excludeNames, entryName(entry.path()))) { process(entry.path(), depth, excludeNames); }
-        }
-    }
-    else if (!omw::contains(excludeNames, entryName(path)))
-    {
-        if (fs::is_regular_file(stat))
-        {
-            SHA1 sha1;
-            std::ifstream fstream(path, std::ios::binary);
-
-            sha1.update(fstream);
-
-            cout << sha1.digest() << " *" << pathStr(path) << endl;
-        }
-        else
-        {
-            if (fs::is_directory(stat))
-            {
-                for (const auto& entry : std::filesystem::directory_iterator(path))
-                {
-                    if (!omw::contains(excludeNames, entryName(entry.path()))) { process(entry.path(), depth, excludeNames); }
-                }
-            }
-            else
-            {
-                cout << std::left << setw(SHA1::digestSize * 2) << ("[" + toString(stat.type()) + "]") << std::right;
-
-                if (fs::is_symlink(stat))
-                {
-                    const fs::path target = fs::weakly_canonical(fs::read_symlink(path));
-
-                    cout << "  " << pathStr(path) << " -> " << pathStr(target);
-                }
-                else { cout << "  " << pathStr(path); }
-
-                cout << endl;
-            }
-        }
-    }
-
-    --depth;
-}
-
-std::string pathStr(const fs::path& path)
-{
-#ifdef OMW_PLAT_WIN
-    std::string r = path.lexically_normal().u8string();
-    return omw::replaceAll(r, '\\', '/');
-#else
-    return path.lexically_normal().u8string();
-#endif
-}
-
-std::string entryName(const fs::path& path)
-{
-    std::string r;
-
-    if (path.has_filename()) { r = path.filename().u8string(); }
-    else { r = path.parent_path().filename().u8string(); }
-
-    return r;
-}
-
-std::string toString(const fs::file_type& type)
-{
-    std::string str;
-
-    switch (type)
-    {
-    case fs::file_type::none:
-        str = "none";
-        break;
-
-    case fs::file_type::not_found:
-        str = "not found";
-        break;
-
-    case fs::file_type::regular:
-        str = "regular file";
-        break;
-
-    case fs::file_type::directory:
-        str = "directory";
-        break;
-
-    case fs::file_type::symlink:
-        str = "symlink";
-        break;
-
-    case fs::file_type::block:
-        str = "block device";
-        break;
-
-    case fs::file_type::character:
-        str = "character device";
-        break;
-
-    case fs::file_type::fifo:
-        str = "fifo/pipe";
-        break;
-
-    case fs::file_type::socket:
-        str = "socket";
-        break;
-
-    case fs::file_type::unknown:
-        str = "unknown";
-        break;
-
-    default:
-        str = "implementation-defined";
-        break;
-    }
-
-    return str;
-}
+void printRecord(const treesha1sum::Record& record) { cout << treesha1sum::manifestLine(record) << endl; }
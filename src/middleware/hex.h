@@ -0,0 +1,90 @@
+/*
+author          Oliver Blaser
+date            18.10.2026
+copyright       GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+*/
+
+/*
+    Lower case hex encoding of binary data, used by all text formats (digests, SHA1 states, path keys).
+*/
+
+#ifndef IG_MIDDLEWARE_HEX_H
+#define IG_MIDDLEWARE_HEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace hex {
+
+/**
+ * @return Value of the digit, -1 if `c` is not a hex digit
+ */
+inline int digitValue(char c)
+{
+    int r = -1;
+
+    if ((c >= '0') && (c <= '9')) { r = c - '0'; }
+    else if ((c >= 'a') && (c <= 'f')) { r = c - 'a' + 10; }
+    else if ((c >= 'A') && (c <= 'F')) { r = c - 'A' + 10; }
+
+    return r;
+}
+
+inline std::string encode(const uint8_t* data, size_t count)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string r;
+    r.reserve(count * 2);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        r += digits[(data[i] >> 4) & 0x0F];
+        r += digits[data[i] & 0x0F];
+    }
+
+    return r;
+}
+
+inline std::string encode(const std::string& data) { return encode((const uint8_t*)data.data(), data.size()); }
+
+/**
+ * @brief Decodes exactly `count` bytes, upper and lower case digits are accepted.
+ *
+ * @return `false` if `str` doesn't consist of `count * 2` hex digits, the content of `data` is unspecified then
+ */
+inline bool decode(const std::string& str, uint8_t* data, size_t count)
+{
+    bool ok = (str.size() == (count * 2));
+
+    for (size_t i = 0; ok && (i < count); ++i)
+    {
+        const int hi = digitValue(str[i * 2]);
+        const int lo = digitValue(str[(i * 2) + 1]);
+
+        if ((hi < 0) || (lo < 0)) { ok = false; }
+        else { data[i] = (uint8_t)((hi << 4) | lo); }
+    }
+
+    return ok;
+}
+
+/**
+ * @return `false` on an odd number of digits or an invalid digit, `data` is left unchanged then
+ */
+inline bool decode(const std::string& str, std::string& data)
+{
+    std::string tmp(str.size() / 2, '\0');
+
+    const bool ok = (((str.size() % 2) == 0) && decode(str, (uint8_t*)tmp.data(), tmp.size()));
+    if (ok) { data = tmp; }
+
+    return ok;
+}
+
+} // namespace hex
+
+
+#endif // IG_MIDDLEWARE_HEX_H
@@ -12,6 +12,7 @@ copyright       GPL-3.0 - Copyright (c) 2024 Oliver Blaser
 #include <string>
 #include <vector>
 
+#include "hex.h"
 #include "sha1.h"
 
 
@@ -72,6 +73,19 @@ void buffer_to_block(const std::string& buffer, uint32_t* block)
     }
 }
 
+void data_to_block(const uint8_t* data, uint32_t* block)
+{
+    for (size_t i = 0; i < blockSize32; ++i)
+    {
+        // clang-format off
+        block[i] = ((uint32_t)(data[4 * i + 3]))       |
+                   ((uint32_t)(data[4 * i + 2]) << 8)  |
+                   ((uint32_t)(data[4 * i + 1]) << 16) |
+                   ((uint32_t)(data[4 * i + 0]) << 24);
+        // clang-format on
+    }
+}
+
 } // namespace
 
 
@@ -88,6 +102,38 @@ void SHA1::update(const std::string& str)
     update(iss);
 }
 
+void SHA1::update(const uint8_t* data, size_t count)
+{
+    uint32_t block[blockSize32];
+
+    // complete the buffered partial block first
+    if (!m_buffer.empty())
+    {
+        const size_t n = ((blockSize - m_buffer.size()) < count ? (blockSize - m_buffer.size()) : count);
+
+        m_buffer.append((const char*)data, n);
+        data += n;
+        count -= n;
+
+        if (m_buffer.size() != blockSize) { return; }
+
+        buffer_to_block(m_buffer, block);
+        m_transform(block);
+        m_buffer.clear();
+    }
+
+    // full blocks are transformed directly from the input, without copying them to the buffer
+    while (count >= blockSize)
+    {
+        data_to_block(data, block);
+        m_transform(block);
+        data += blockSize;
+        count -= blockSize;
+    }
+
+    m_buffer.append((const char*)data, count);
+}
+
 void SHA1::update(std::istream& istream)
 {
     while (true)
@@ -134,6 +180,57 @@ std::string SHA1::final() const
     return digest();
 }
 
+std::string SHA1::exportState() const
+{
+    if (m_finalDone) { return ""; }
+
+    std::ostringstream result;
+    result << std::hex << std::setfill('0');
+
+    for (size_t i = 0; i < (sizeof(m_digest) / sizeof(m_digest[0])); ++i) { result << std::setw(8) << m_digest[i]; }
+
+    result << std::setw(16) << m_nTransformations;
+
+    result << hex::encode(m_buffer);
+
+    return result.str();
+}
+
+bool SHA1::importState(const std::string& state)
+{
+    constexpr size_t nDigestDigits = digestSize * 2;
+    constexpr size_t nHeaderDigits = nDigestDigits + 16;
+
+    bool ok = (state.size() >= nHeaderDigits) && (state.size() < (nHeaderDigits + blockSize * 2)) && ((state.size() % 2) == 0);
+
+    uint8_t header[digestSize + 8]; // digest and number of transformations, big endian
+    std::string buffer;
+
+    if (ok) { ok = hex::decode(state.substr(0, nHeaderDigits), header, sizeof(header)); }
+    if (ok) { ok = hex::decode(state.substr(nHeaderDigits), buffer); }
+
+    if (ok)
+    {
+        for (size_t i = 0; i < (sizeof(m_digest) / sizeof(m_digest[0])); ++i)
+        {
+            // clang-format off
+            m_digest[i] = ((uint32_t)(header[4 * i + 3]))       |
+                          ((uint32_t)(header[4 * i + 2]) << 8)  |
+                          ((uint32_t)(header[4 * i + 1]) << 16) |
+                          ((uint32_t)(header[4 * i + 0]) << 24);
+            // clang-format on
+        }
+
+        m_nTransformations = 0;
+        for (size_t i = digestSize; i < sizeof(header); ++i) { m_nTransformations = (m_nTransformations << 8) | header[i]; }
+
+        m_buffer = buffer;
+        m_finalDone = false;
+    }
+
+    return ok;
+}
+
 std::string SHA1::digest() const
 {
     if (!m_finalDone) { return final(); }
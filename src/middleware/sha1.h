@@ -71,12 +71,27 @@ public:
 
     void update(const char* str);
     void update(const std::string& str);
-    void update(const uint8_t* data, size_t count) { update(std::string(data, data + count)); }
+    void update(const uint8_t* data, size_t count);
     void update(const std::vector<uint8_t>& data) { update(data.data(), data.size()); }
     void update(std::istream& istream);
 
     std::string final() const;
 
+    /**
+     * @brief Exports the intermediate state, hashing can be continued later on with `importState()`.
+     *
+     * The state is a hex string of the digest words, the number of transformations and the buffered tail (less than
+     * one block). Returns an empty string if `final()` has already been done.
+     */
+    std::string exportState() const;
+
+    /**
+     * @brief Restores a state exported by `exportState()`.
+     *
+     * @return `false` if the state string is malformed, the object is left unchanged in that case
+     */
+    bool importState(const std::string& state);
+
     std::string digest() const;
 
     operator std::string() const { return digest(); }
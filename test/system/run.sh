@@ -0,0 +1,423 @@
+#!/bin/bash
+
+# author        Oliver Blaser
+# date          18.10.2026
+# copyright     GPL-3.0 - Copyright (c) 2026 Oliver Blaser
+
+# Usage:
+#   ./run.sh [BINARY]
+#
+# run script in test/system/, BINARY defaults to ../../build/cmake/treesha1sum
+
+
+
+bin=$(realpath "${1:-../../build/cmake/treesha1sum}")
+tmpDir=$(mktemp -d)
+trap 'rm -rf "$tmpDir"' EXIT
+
+errCnt=0
+
+# name, actual, expected (files, compared without order)
+function compareSorted()
+{
+    if diff <(sort "$2") <(sort "$3") > "$tmpDir/diff.txt"
+    then
+        echo -e "$1 \033[92mOK\033[39m"
+    else
+        echo -e "$1 \033[91mFAILED\033[39m"
+        cat "$tmpDir/diff.txt"
+        ((++errCnt))
+    fi
+}
+
+# name, options... (hashes input/, the output has to be the same as without options, stderr is ignored)
+function compareInput()
+{
+    local name=$1
+    shift
+
+    (cd input && "$bin" "$@") > "$tmpDir/input-options.txt" 2> /dev/null
+    compareSorted "$name" "$tmpDir/input-options.txt" output-expected.txt
+}
+
+# name, command... (has to fail without crashing)
+function expectError()
+{
+    local name=$1
+    shift
+
+    "$@" > "$tmpDir/error.txt" 2>&1
+    local ec=$?
+
+    if [ $ec -eq 1 ]
+    then
+        echo -e "$name \033[92mOK\033[39m"
+    else
+        echo -e "$name \033[91mFAILED\033[39m (exit code $ec)"
+        cat "$tmpDir/error.txt"
+        ((++errCnt))
+    fi
+}
+
+
+
+function test_input()
+{
+    (cd input && "$bin") > "$tmpDir/input.txt"
+    compareSorted "input" "$tmpDir/input.txt" output-expected.txt
+}
+
+function test_sparse()
+{
+    local dir="$tmpDir/sparse"
+    mkdir -p "$dir"
+
+    truncate -s 1M "$dir/hole-start"
+    echo "data" >> "$dir/hole-start"
+    echo "data" > "$dir/hole-end"
+    truncate -s 1M "$dir/hole-end"
+    echo "data" > "$dir/hole-middle"
+    truncate -s 1M "$dir/hole-middle"
+    echo "data" >> "$dir/hole-middle"
+    truncate -s 1M "$dir/fully-sparse"
+
+    (cd "$dir" && sha1sum -b *) > "$tmpDir/sparse-expected.txt"
+
+    for io in sparse block
+    do
+        (cd "$dir" && "$bin" --io $io) > "$tmpDir/sparse.txt"
+        compareSorted "sparse --io $io" "$tmpDir/sparse.txt" "$tmpDir/sparse-expected.txt"
+    done
+}
+
+function test_filter()
+{
+    local dir="$tmpDir/filter"
+    mkdir -p "$dir/sub/deep"
+
+    echo "small" > "$dir/small"
+    yes "lorem ipsum" | head -c 2048 > "$dir/large"
+    echo "old" > "$dir/sub/old"
+    touch -d @1000000000 "$dir/sub/old"
+    echo "deep" > "$dir/sub/deep/file"
+    ln -s small "$dir/link"
+
+    # the filtered outputs are subsets of the unfiltered output
+    (cd "$dir" && "$bin") > "$tmpDir/filter-all.txt"
+
+    (cd "$dir" && "$bin" --min-size 1k) > "$tmpDir/filter.txt"
+    grep " \*large$" "$tmpDir/filter-all.txt" > "$tmpDir/filter-expected.txt"
+    compareSorted "filter --min-size" "$tmpDir/filter.txt" "$tmpDir/filter-expected.txt"
+
+    # the size suffixes are case insensitive
+    (cd "$dir" && "$bin" --max-size 1m) > "$tmpDir/filter.txt"
+    grep -v "^\[symlink\]" "$tmpDir/filter-all.txt" > "$tmpDir/filter-expected.txt"
+    compareSorted "filter --max-size" "$tmpDir/filter.txt" "$tmpDir/filter-expected.txt"
+
+    (cd "$dir" && "$bin" --newer-than @1000000001) > "$tmpDir/filter.txt"
+    grep -E " \*(small|large|sub/deep/file)$" "$tmpDir/filter-all.txt" > "$tmpDir/filter-expected.txt"
+    compareSorted "filter --newer-than" "$tmpDir/filter.txt" "$tmpDir/filter-expected.txt"
+
+    (cd "$dir" && "$bin" --type l) > "$tmpDir/filter.txt"
+    grep "^\[symlink\]" "$tmpDir/filter-all.txt" > "$tmpDir/filter-expected.txt"
+    compareSorted "filter --type" "$tmpDir/filter.txt" "$tmpDir/filter-expected.txt"
+
+    (cd "$dir" && "$bin" --max-depth 2) > "$tmpDir/filter.txt"
+    grep -v "sub/deep/" "$tmpDir/filter-all.txt" > "$tmpDir/filter-expected.txt"
+    compareSorted "filter --max-depth" "$tmpDir/filter.txt" "$tmpDir/filter-expected.txt"
+
+    # a file list has no directory levels
+    expectError "filter --max-depth --files-from" "$bin" --max-depth 1 --files-from - < /dev/null
+    expectError "filter --one-file-system --files-from" "$bin" --one-file-system --files-from - < /dev/null
+
+    (cd "$dir" && "$bin" --type f --max-size 1k --max-depth 1) > "$tmpDir/filter.txt"
+    grep " \*small$" "$tmpDir/filter-all.txt" > "$tmpDir/filter-expected.txt"
+    compareSorted "filter combined" "$tmpDir/filter.txt" "$tmpDir/filter-expected.txt"
+}
+
+function test_checkpoint()
+{
+    local cp="$tmpDir/checkpoint"
+
+    (cd input && "$bin" --checkpoint "$cp") > "$tmpDir/checkpoint.txt"
+    compareSorted "checkpoint" "$tmpDir/checkpoint.txt" output-expected.txt
+
+    # checkpoints are only written for DIRECTORY, the other inputs must not ignore them silently
+    expectError "checkpoint --quick" "$bin" --checkpoint "$cp" --quick input
+    expectError "checkpoint --tar" "$bin" --checkpoint "$cp" --resume --tar input.tar
+    expectError "checkpoint --files-from" "$bin" --checkpoint "$cp" --files-from - < /dev/null
+    expectError "checkpoint --from-text" "$bin" --checkpoint "$cp" --from-text output-expected.txt
+}
+
+function test_diskSchedule()
+{
+    compareInput "schedule disk" --schedule disk
+    compareInput "schedule disk threads 4" --schedule disk --threads 4
+
+    local dir="$tmpDir/links"
+    mkdir -p "$dir/links"
+    echo "regular" > "$dir/a"
+    (cd "$dir/links" && for i in $(seq 4200); do ln -s ../a "l$i"; done)
+
+    (cd "$dir" && "$bin") > "$tmpDir/links-expected.txt"
+
+    # more entries without a job than the window after a file, its job is still in the unsubmitted batch
+    (cd "$dir" && printf "a\0" && find links -type l -print0) > "$tmpDir/links-list.txt"
+    (cd "$dir" && timeout 60 "$bin" --threads 2 --schedule disk --files-from - --null < "$tmpDir/links-list.txt") > "$tmpDir/links.txt"
+    compareSorted "disk schedule many links" "$tmpDir/links.txt" "$tmpDir/links-expected.txt"
+
+    (cd "$dir" && timeout 60 "$bin" --threads 2 --schedule disk) > "$tmpDir/links.txt"
+    compareSorted "disk schedule many links dir" "$tmpDir/links.txt" "$tmpDir/links-expected.txt"
+}
+
+function test_incremental()
+{
+    local dir="$tmpDir/incremental"
+    local state="$tmpDir/incremental.state"
+    mkdir -p "$dir"
+
+    # the state is only kept for files of at least 1 MiB
+    yes "log line" | head -c 2M > "$dir/log"
+    echo "small" > "$dir/small"
+
+    local name
+    for name in first append unchanged rewrite truncate
+    do
+        case $name in
+            append) yes "appended" | head -c 100k >> "$dir/log" ;;
+            # changed inside the last 4 KiB of the previous content, the tail fingerprint must not match
+            rewrite)
+                printf "rewritten" | dd of="$dir/log" bs=1 seek=$(($(stat -c %s "$dir/log") - 100)) conv=notrunc status=none
+                echo "more" >> "$dir/log"
+                ;;
+            truncate) truncate -s 1536k "$dir/log" ;;
+        esac
+
+        (cd "$dir" && "$bin" --incremental "$state") > "$tmpDir/incremental.txt"
+        (cd "$dir" && sha1sum -b log small) > "$tmpDir/incremental-expected.txt"
+        compareSorted "incremental $name" "$tmpDir/incremental.txt" "$tmpDir/incremental-expected.txt"
+    done
+}
+
+function test_threads()
+{
+    compareInput "threads 4" --threads 4
+    compareInput "threads 0" --threads 0
+
+    local io
+    for io in block sparse stream
+    do
+        compareInput "threads 4 --io $io" --threads 4 --io $io
+    done
+}
+
+function test_largestFirst()
+{
+    compareInput "schedule largest" --schedule largest
+    compareInput "schedule largest threads 4" --schedule largest --threads 4
+}
+
+function test_progress()
+{
+    local nFiles=$(find input -type f | wc -l)
+    local nBytes=$(find input -type f -exec cat {} + | wc -c)
+
+    local threads
+    for threads in 1 4
+    do
+        (cd input && "$bin" --progress-log 1 --threads $threads) > "$tmpDir/progress.txt" 2> "$tmpDir/progress-log.txt"
+        compareSorted "progress-log threads $threads" "$tmpDir/progress.txt" output-expected.txt
+
+        # the last line is written when done
+        tail -n 1 "$tmpDir/progress-log.txt" | cut -d " " -f 1-3 > "$tmpDir/progress.txt"
+        echo "progress files=$nFiles/$nFiles bytes=$nBytes/$nBytes" > "$tmpDir/progress-expected.txt"
+        compareSorted "progress-log threads $threads done" "$tmpDir/progress.txt" "$tmpDir/progress-expected.txt"
+    done
+
+    # the status line is only written to a terminal
+    (cd input && "$bin" --progress) > "$tmpDir/progress.txt" 2> "$tmpDir/progress-log.txt"
+    compareSorted "progress" "$tmpDir/progress.txt" output-expected.txt
+    compareSorted "progress no terminal" "$tmpDir/progress-log.txt" /dev/null
+}
+
+function test_rateLimit()
+{
+    compareInput "rate limit" --max-read-rate 1m --max-iops 1000 --max-cpu 50 --idle-io
+    compareInput "rate limit threads 4" --max-read-rate 1m --max-iops 1000 --max-cpu 50 --idle-io --threads 4
+
+    # 2 MiB at 8 MiB/s, the readers have to be throttled
+    local dir="$tmpDir/rate"
+    mkdir -p "$dir"
+    head -c 2M /dev/zero > "$dir/zero"
+
+    (cd "$dir" && "$bin" --max-read-rate 8M) > "$tmpDir/rate.txt" 2> "$tmpDir/rate-stats.txt"
+    (cd "$dir" && sha1sum -b zero) > "$tmpDir/rate-expected.txt"
+    compareSorted "rate limit throttled" "$tmpDir/rate.txt" "$tmpDir/rate-expected.txt"
+
+    if grep -q "throttled 0.0 s" "$tmpDir/rate-stats.txt"
+    then
+        echo -e "rate limit not throttled \033[91mFAILED\033[39m"
+        cat "$tmpDir/rate-stats.txt"
+        ((++errCnt))
+    fi
+}
+
+function test_filesFrom()
+{
+    (cd input && find . -mindepth 1 -printf "%P\n" | "$bin" --files-from -) > "$tmpDir/list.txt"
+    compareSorted "files-from" "$tmpDir/list.txt" output-expected.txt
+
+    (cd input && find . -type f -printf "%P\0" | "$bin" --files-from - --null) > "$tmpDir/list.txt"
+    compareSorted "files-from null" "$tmpDir/list.txt" output-expected.txt
+
+    expectError "null without files-from" "$bin" --null input
+}
+
+function test_tar()
+{
+    # contains a GNU volume label, a pax path override, a GNU long name, a hard link and a symlink
+    "$bin" --tar input.tar > "$tmpDir/tar.txt"
+    compareSorted "tar" "$tmpDir/tar.txt" output-expected.tar.txt
+
+    "$bin" --tar - < input.tar > "$tmpDir/tar.txt"
+    compareSorted "tar stdin" "$tmpDir/tar.txt" output-expected.tar.txt
+
+    head -c 2000 input.tar > "$tmpDir/truncated.tar"
+    expectError "tar truncated" "$bin" --tar "$tmpDir/truncated.tar"
+}
+
+function test_binaryManifest()
+{
+    local manifest="$tmpDir/manifest.bin"
+
+    "$bin" --from-text output-expected.txt --binary "$manifest"
+    "$bin" --from-binary "$manifest" > "$tmpDir/binary.txt"
+    compareSorted "binary manifest" "$tmpDir/binary.txt" output-expected.txt
+
+    "$bin" --from-binary "$manifest" --lookup ä > "$tmpDir/binary.txt"
+    grep "\*ä/" output-expected.txt > "$tmpDir/binary-expected.txt"
+    compareSorted "binary manifest lookup dir" "$tmpDir/binary.txt" "$tmpDir/binary-expected.txt"
+
+    "$bin" --from-binary "$manifest" --lookup "lorem ipsum.txt" > "$tmpDir/binary.txt"
+    grep "\*lorem ipsum.txt$" output-expected.txt > "$tmpDir/binary-expected.txt"
+    compareSorted "binary manifest lookup file" "$tmpDir/binary.txt" "$tmpDir/binary-expected.txt"
+
+    head -c 40 "$manifest" > "$tmpDir/truncated.bin"
+    expectError "binary manifest truncated" "$bin" --from-binary "$tmpDir/truncated.bin"
+
+    # entry count and section offset large enough to overflow the bounds checks
+    cp "$manifest" "$tmpDir/corrupt.bin"
+    printf '\xf0\xff\xff\xff\xff\xff\xff\xff' | dd of="$tmpDir/corrupt.bin" bs=1 seek=16 conv=notrunc status=none
+    expectError "binary manifest corrupt count" "$bin" --from-binary "$tmpDir/corrupt.bin"
+
+    cp "$manifest" "$tmpDir/corrupt.bin"
+    printf '\x00\xff\xff\xff\xff\xff\xff\xff' | dd of="$tmpDir/corrupt.bin" bs=1 seek=24 conv=notrunc status=none
+    expectError "binary manifest corrupt offset" "$bin" --from-binary "$tmpDir/corrupt.bin"
+
+    # the index is only checked when it's used
+    local indexOffset=$(od -An -t u8 -j 56 -N 8 "$manifest" | tr -d " ")
+    cp "$manifest" "$tmpDir/corrupt.bin"
+    printf '\xff\xff\xff\xff\xff\xff\xff\x00' | dd of="$tmpDir/corrupt.bin" bs=1 seek=$indexOffset conv=notrunc status=none
+    expectError "binary manifest corrupt index" "$bin" --from-binary "$tmpDir/corrupt.bin" --lookup ä
+
+    expectError "binary manifest text file" "$bin" --from-binary output-expected.txt
+}
+
+function test_gitBlob()
+{
+    if ! command -v git > /dev/null
+    then
+        echo "git-blob skipped, git not found"
+        return
+    fi
+
+    local repo="$tmpDir/git"
+    mkdir -p "$repo/sub"
+    cp "input/lorem ipsum.txt" "$repo/"
+    : > "$repo/empty"
+    printf 'a\r\nb\r\n' > "$repo/sub/crlf.txt"
+
+    # older than the index, otherwise the entries are racily clean and not used
+    touch -d "1 hour ago" "$repo/lorem ipsum.txt" "$repo/empty" "$repo/sub/crlf.txt"
+
+    git -C "$repo" init -q
+    git -C "$repo" config core.autocrlf false
+    git -C "$repo" add -A
+
+    (cd "$repo" && for f in "lorem ipsum.txt" empty sub/crlf.txt; do echo "$(git hash-object --no-filters "$f") *$f"; done) > "$tmpDir/git-expected.txt"
+
+    (cd "$repo" && "$bin" --git-blob --exclude .git) > "$tmpDir/git.txt"
+    compareSorted "git-blob" "$tmpDir/git.txt" "$tmpDir/git-expected.txt"
+
+    (cd "$repo" && "$bin" --git-blob --use-git-index --exclude .git) > "$tmpDir/git.txt"
+    compareSorted "git-blob index" "$tmpDir/git.txt" "$tmpDir/git-expected.txt"
+
+    # the index contains the id of the content with LF line endings now, it must not be used
+    git -C "$repo" config core.autocrlf true
+    git -C "$repo" add --renormalize .
+
+    (cd "$repo" && "$bin" --git-blob --use-git-index --exclude .git) > "$tmpDir/git.txt"
+    compareSorted "git-blob index autocrlf" "$tmpDir/git.txt" "$tmpDir/git-expected.txt"
+
+    git -C "$repo" config core.autocrlf false
+    echo "*.txt text eol=crlf" > "$repo/sub/.gitattributes"
+    touch -d "1 hour ago" "$repo/sub/.gitattributes"
+    git -C "$repo" add -A
+    echo "$(git -C "$repo" hash-object --no-filters sub/.gitattributes) *sub/.gitattributes" >> "$tmpDir/git-expected.txt"
+
+    (cd "$repo" && "$bin" --git-blob --use-git-index --exclude .git) > "$tmpDir/git.txt"
+    compareSorted "git-blob index attributes" "$tmpDir/git.txt" "$tmpDir/git-expected.txt"
+}
+
+
+function test_escalate()
+{
+    local dir="$tmpDir/escalate"
+    mkdir -p "$dir"
+    cp "input/lorem ipsum.txt" input/empty.txt "$dir/"
+
+    (cd "$dir" && "$bin" --quick) > "$tmpDir/escalate-1.txt"
+    echo "changed" >> "$dir/empty.txt"
+    (cd "$dir" && "$bin" --quick --escalate "$tmpDir/escalate-1.txt") > "$tmpDir/escalate-2.txt"
+    (cd "$dir" && "$bin" --quick --escalate "$tmpDir/escalate-2.txt") > "$tmpDir/escalate-3.txt"
+
+    # the changed file is escalated once, its fingerprint is in the output too, so that it's not escalated again
+    grep -v "^quick:" "$tmpDir/escalate-2.txt" > "$tmpDir/escalate.txt"
+    echo "$(sha1sum < "$dir/empty.txt" | cut -d " " -f 1) *empty.txt" > "$tmpDir/escalate-expected.txt"
+    compareSorted "escalate" "$tmpDir/escalate.txt" "$tmpDir/escalate-expected.txt"
+
+    grep "^quick:" "$tmpDir/escalate-2.txt" > "$tmpDir/escalate-expected.txt"
+    compareSorted "escalate baseline" "$tmpDir/escalate-3.txt" "$tmpDir/escalate-expected.txt"
+
+    # the lookup of an escalated file finds the SHA1 record
+    "$bin" --from-text "$tmpDir/escalate-2.txt" --binary "$tmpDir/escalate.bin"
+    "$bin" --from-binary "$tmpDir/escalate.bin" --lookup empty.txt > "$tmpDir/escalate.txt"
+    echo "$(sha1sum < "$dir/empty.txt" | cut -d " " -f 1) *empty.txt" > "$tmpDir/escalate-expected.txt"
+    compareSorted "escalate binary lookup" "$tmpDir/escalate.txt" "$tmpDir/escalate-expected.txt"
+}
+
+
+
+test_input
+test_threads
+test_largestFirst
+test_progress
+test_rateLimit
+test_filesFrom
+test_sparse
+test_filter
+test_checkpoint
+test_incremental
+test_diskSchedule
+test_tar
+test_binaryManifest
+test_escalate
+test_gitBlob
+
+if [ $errCnt -ne 0 ]
+then
+    echo -e "\033[91m$errCnt FAILED\033[39m"
+    exit 1
+fi
+
+echo -e "\033[92mOK\033[39m"
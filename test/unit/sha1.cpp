@@ -40,6 +40,18 @@ int main()
 
     const SHA1 sha1_bin_3(bin.data(), 3);
 
+    SHA1 sha1_million_a_raw; // odd chunk size to hit the partial block handling of the raw data update
+    {
+        const std::vector<uint8_t> a(97, 'a');
+        size_t n = 1000000;
+        while (n > 0)
+        {
+            const size_t count = (n < a.size() ? n : a.size());
+            sha1_million_a_raw.update(a.data(), count);
+            n -= count;
+        }
+    }
+
     SHA1 sha1_tmp;
     sha1_tmp.update("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu");
 
@@ -51,6 +63,7 @@ int main()
         { "84983e441c3bd26ebaae4aa1f95129e5e54670f1", SHA1("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") },
         { "a49b2446a02c645bf419f995b67091253a04a259", sha1_tmp.digest() },
         { "34aa973cd4c4daa4f61eeb2bdbad27316534016f", sha1_million_a.final() },
+        { "34aa973cd4c4daa4f61eeb2bdbad27316534016f", sha1_million_a_raw },
         { "16312751ef9307c3fd1afbcb993cdc80464ba0f1", SHA1("the quick brown fox jumps over the lazy dog") },
         { "2cbd0727187241f9a1b366c498c334229f6c913f", SHA1(bin) },
         { "b203c5a0c19f15f173698158e08f83ca07638574", sha1_bin_3 },
@@ -61,6 +74,26 @@ int main()
     sha1_tmp.update("1234");
     testVector.push_back({ "f58cf5e7e10f195e21b553096d092c763ed18b0e", sha1_tmp });
 
+    // continue hashing on an other object with an exported state
+    {
+        SHA1 a;
+        a.update("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+                 "abcdbcdecdefdefgefghfghighijhijkijkljk");
+
+        SHA1 b;
+        if (!b.importState(a.exportState())) { r = 1; }
+        b.update("lmklmnlmnomnopnopq");
+
+        testVector.push_back({ "afc53a4ea20856f98e08dc6f3a5c9833137768ed", b });
+
+        // invalid states have to be rejected
+        if (b.importState("0123"))
+        {
+            cout << "importState() accepted an invalid state \033[91mFAILED\033[39m" << endl;
+            r = 1;
+        }
+    }
+
     for (size_t i = 0; i < testVector.size(); ++i)
     {
         const auto& tmp = testVector[i];